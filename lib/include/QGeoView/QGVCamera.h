@@ -22,6 +22,7 @@
 
 #include <QAbstractAnimation>
 #include <QEasingCurve>
+#include <QPolygonF>
 
 class QGVMap;
 class QGVProjection;
@@ -30,6 +31,11 @@ class QGV_LIB_DECL QGVCameraState
 {
 public:
     explicit QGVCameraState(QGVMap* geoMap, double azimuth, double scale, const QRectF& projRect, bool animation);
+    explicit QGVCameraState(QGVMap* geoMap,
+                            double azimuth,
+                            double scale,
+                            const QPolygonF& projPolygon,
+                            bool animation);
     QGVCameraState(const QGVCameraState& other);
     QGVCameraState(const QGVCameraState&& other);
     QGVCameraState& operator=(const QGVCameraState& other);
@@ -41,6 +47,7 @@ public:
     double scale() const;
     double azimuth() const;
     QRectF projRect() const;
+    QPolygonF projPolygon() const;
     QPointF projCenter() const;
     bool animation() const;
 
@@ -52,6 +59,7 @@ private:
     double mScale;
     double mAzimuth;
     QRectF mProjRect;
+    QPolygonF mProjPolygon;
     bool mAnimation;
 };
 
@@ -93,6 +101,7 @@ public:
     void setDuration(int msecs);
     int duration() const override;
     QGVCameraActions& actions();
+    QList<QGVCameraState> plan(int samples);
 
 protected:
     virtual void onStart();
@@ -134,6 +143,7 @@ public:
 
 private:
     void onStart() override;
+    void onStop() override;
     void onProgress(double progress, QGVCameraActions& target) override;
 
 private:
@@ -23,6 +23,8 @@
 #include "QGVMap.h"
 #include "QGVMapQGItem.h"
 
+class QGVSpatialIndex;
+
 class QGV_LIB_DECL QGVDrawItem : public QGVItem
 {
     Q_OBJECT
@@ -30,6 +32,7 @@ class QGV_LIB_DECL QGVDrawItem : public QGVItem
 
 public:
     QGVDrawItem();
+    ~QGVDrawItem();
 
     void setFlags(QGV::ItemFlags flags);
     void setFlag(QGV::ItemFlag flag, bool enabled = true);
@@ -60,8 +63,14 @@ protected:
     void onUpdate() override;
     void onClean() override;
 
+private:
+    void updateIndex();
+    void removeIndex();
+
 private:
     QGV::ItemFlags mFlags;
     QScopedPointer<QGVMapQGItem> mQGDrawItem;
     bool mDirty;
+    bool mIndexDirty;
+    QGVSpatialIndex* mIndex;
 };
@@ -32,6 +32,12 @@
 #endif
 #endif
 
+class QGVTileCache;
+class QGVTileDecoder;
+class QGVTileDownloader;
+class QGVTileScheduler;
+class QGVTileStore;
+
 namespace QGV {
 
 enum class Projection
@@ -66,6 +72,13 @@ enum class MapState
     SelectionRect,
 };
 
+enum class ServerSharding
+{
+    Disabled,
+    TileHash,
+    LeastOutstanding,
+};
+
 enum class DistanceUnits
 {
     Meters,
@@ -98,6 +111,8 @@ enum class ItemFlag : int
     Transformed = 0x40,
     Clickable = 0x80,
     Movable = 0x100,
+    NoCache = 0x200,
+    NoSearch = 0x400,
 };
 Q_DECLARE_FLAGS(ItemFlags, ItemFlag)
 
@@ -171,6 +186,8 @@ public:
     GeoTilePos& operator=(const GeoTilePos&& other);
 
     bool operator<(const GeoTilePos& other) const;
+    bool operator==(const GeoTilePos& other) const;
+    bool operator!=(const GeoTilePos& other) const;
 
     int zoom() const;
     QPoint pos() const;
@@ -188,9 +205,22 @@ private:
     QPoint mPos;
 };
 
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+QGV_LIB_DECL size_t qHash(const GeoTilePos& key, size_t seed = 0);
+#else
+QGV_LIB_DECL uint qHash(const GeoTilePos& key, uint seed = 0);
+#endif
+
 QGV_LIB_DECL void setNetworkManager(QNetworkAccessManager* manager);
 QGV_LIB_DECL QNetworkAccessManager* getNetworkManager();
 
+QGV_LIB_DECL void setTileStore(QGVTileStore* store);
+QGV_LIB_DECL QGVTileStore* getTileStore();
+QGV_LIB_DECL QGVTileCache* getTileCache();
+QGV_LIB_DECL QGVTileDecoder* getTileDecoder();
+QGV_LIB_DECL QGVTileDownloader* getTileDownloader();
+QGV_LIB_DECL QGVTileScheduler* getTileScheduler();
+
 QGV_LIB_DECL QTransform createTransfrom(QPointF const& projAnchor, double scale, double azimuth);
 QGV_LIB_DECL QTransform createTransfromScale(QPointF const& projAnchor, double scale);
 QGV_LIB_DECL QTransform createTransfromAzimuth(QPointF const& projAnchor, double azimuth);
@@ -40,6 +40,9 @@ public:
 
     void addItem(QGVItem* item);
     void removeItem(QGVItem* item);
+    void addItems(const QList<QGVItem*>& items);
+    void removeItems(const QList<QGVItem*>& items);
+    QList<QGVItem*> takeAll();
     void deleteItems();
     int countItems() const;
     QGVItem* getItem(int index) const;
@@ -73,16 +76,48 @@ public:
 
     virtual void onProjection(QGVMap* geoMap);
     virtual void onCamera(const QGVCameraState& oldState, const QGVCameraState& newState);
+    virtual void onCameraPlan(const QList<QGVCameraState>& plan);
     virtual void onUpdate();
     virtual void onClean();
 
+private:
+    friend class QGVMap;
+    void attachChild(QGVItem* item);
+    void detachChild(QGVItem* item);
+    void compactChildren() const;
+    void updateNow();
+    void cancelUpdate();
+    void invalidateEffective();
+    void validateEffective() const;
+
+    template<typename Func>
+    void forEachChild(Func func) const
+    {
+        // Slots emptied during iteration are skipped
+        compactChildren();
+        for (int i = 0; i < mChildrens.size(); ++i) {
+            QGVItem* obj = mChildrens.at(i);
+            if (obj != nullptr) {
+                func(obj);
+            }
+        }
+    }
+
 private:
     Q_DISABLE_COPY(QGVItem)
     QGVItem* mParent;
+    int mIndexInParent;
     qint16 mZValue;
     double mOpacity;
     bool mVisible;
     bool mSelectable;
     bool mSelected;
-    QList<QGVItem*> mChildrens;
+    QGVMap* mUpdateMap;
+    mutable bool mEffectiveValid;
+    mutable bool mEffectiveVisible;
+    mutable double mEffectiveOpacity;
+    mutable double mEffectiveZValue;
+    mutable double mEffectiveZScale;
+    mutable QList<QGVItem*> mChildrens;
+    mutable int mDeadChildren;
 };
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "QGVLayerTilesOnline.h"
+#include "QGVUrlTemplate.h"
 
 class QGV_LIB_DECL QGVLayerBDGEx : public QGVLayerTilesOnline
 {
@@ -30,12 +31,20 @@ public:
 
     void setUrl(const QString& url);
     QString getUrl() const;
+    void setMetatileSize(int size);
+    int getMetatileSize() const;
+    QString getTilesId() const override;
 
 private:
     int minZoomlevel() const override;
     int maxZoomlevel() const override;
     QString tilePosToUrl(const QGV::GeoTilePos& tilePos) const override;
+    int metatileSize() const override;
+    QString metatileToUrl(const QGV::GeoTilePos& tilePos, const QSize& tiles) const override;
+    QString rectToUrl(const QGV::GeoRect& rect, int widthTiles) const;
 
 private:
     QString mUrl;
+    QGVUrlTemplate mUrlTemplate;
+    int mMetatileSize;
 };
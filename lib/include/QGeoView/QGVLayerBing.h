@@ -19,6 +19,7 @@
 #pragma once
 
 #include "QGVLayerTilesOnline.h"
+#include "QGVUrlTemplate.h"
 
 class QGV_LIB_DECL QGVLayerBing : public QGVLayerTilesOnline
 {
@@ -37,6 +38,8 @@ public:
 
 private:
     void createName();
+    void createUrlTemplate();
+    QString getTilesId() const override;
     int minZoomlevel() const override;
     int maxZoomlevel() const override;
     QString tilePosToUrl(const QGV::GeoTilePos& tilePos) const override;
@@ -45,4 +48,5 @@ private:
     QGV::TilesType mType;
     QLocale mLocale;
     int mServerNumber;
+    QVector<QGVUrlTemplate> mUrlTemplates;
 };
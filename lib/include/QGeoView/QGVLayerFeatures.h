@@ -0,0 +1,118 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVLayer.h"
+
+#include <QBrush>
+#include <QPen>
+#include <QVector>
+
+/*!
+ * Layer for massive amount of simple features (points, lines and polygons).
+ * Features are not items: they are kept in contiguous arrays and addressed by index, whole layer
+ * is painted by one scene item. Visible features are found by uniform grid over projection bounds.
+ */
+class QGV_LIB_DECL QGVLayerFeatures : public QGVLayer
+{
+    Q_OBJECT
+
+public:
+    QGVLayerFeatures();
+    ~QGVLayerFeatures();
+
+    int addStyle(const QPen& pen, const QBrush& brush = QBrush(), double pointSize = 6);
+    int countStyles() const;
+
+    void reserve(int features, int points);
+    int addPoint(const QGV::GeoPos& geoPos, int style = 0);
+    int addLine(const QList<QGV::GeoPos>& geoPoints, int style = 0);
+    int addPolygon(const QList<QGV::GeoPos>& geoPoints, int style = 0);
+    void clearFeatures();
+    int countFeatures() const;
+
+    void setFeatureStyle(int feature, int style);
+    int getFeatureStyle(int feature) const;
+    void setFeatureVisible(int feature, bool visible);
+    bool isFeatureVisible(int feature) const;
+    void setFeatureSelected(int feature, bool selected);
+    bool isFeatureSelected(int feature) const;
+
+    QRectF featureProjRect(int feature) const;
+    QVector<int> searchFeatures(const QRectF& projRect) const;
+    int featureAt(const QPointF& projPos, double projTolerance) const;
+
+protected:
+    void onProjection(QGVMap* geoMap) override;
+    void onUpdate() override;
+    void onClean() override;
+
+private:
+    class Renderer;
+    enum Type : quint8
+    {
+        Point,
+        Line,
+        Polygon,
+    };
+    enum Flag : quint8
+    {
+        Hidden = 0x1,
+        Selected = 0x2,
+    };
+    struct Style
+    {
+        QPen pen;
+        QBrush brush;
+        double pointSize;
+    };
+
+    int addFeature(Type type, const QList<QGV::GeoPos>& geoPoints, int style);
+    void setFeatureFlag(int feature, Flag flag, bool enabled);
+    void projectPoints(int first);
+    void changed();
+    void repaint();
+    void buildGrid() const;
+    void collectFeatures(const QRectF& projRect, QVector<int>& features) const;
+    void paintFeatures(QPainter* painter, const QRectF& projRect);
+    bool isFeatureAt(int feature, const QPointF& projPos, double projTolerance) const;
+
+private:
+    QVector<Style> mStyles;
+    QVector<quint8> mTypes;
+    QVector<quint8> mFlags;
+    QVector<quint16> mStyleIndex;
+    QVector<quint32> mOffsets;
+    QVector<QPointF> mGeoPoints;
+    QVector<QPointF> mProjPoints;
+    QGVProjection* mProjection;
+    QScopedPointer<Renderer> mRenderer;
+    QMetaObject::Connection mSceneConnection;
+
+    mutable bool mGridDirty;
+    mutable QRectF mGridRect;
+    mutable QSizeF mGridCell;
+    mutable QSizeF mGridExtent;
+    mutable int mGridSize;
+    mutable QVector<quint32> mGridStart;
+    mutable QVector<quint32> mGridItems;
+    mutable QVector<quint32> mGridLarge;
+    QVector<int> mPaintFeatures;
+    QVector<QPointF> mPaintPoints;
+};
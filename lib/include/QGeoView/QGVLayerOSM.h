@@ -19,6 +19,7 @@
 #pragma once
 
 #include "QGVLayerTilesOnline.h"
+#include "QGVUrlTemplate.h"
 
 class QGV_LIB_DECL QGVLayerOSM : public QGVLayerTilesOnline
 {
@@ -30,12 +31,20 @@ public:
 
     void setUrl(const QString& url);
     QString getUrl() const;
+    void setRetinaTiles(bool enabled);
+    bool isRetinaTiles() const;
+    QString getTilesId() const override;
 
 private:
+    bool isRetinaUrl() const;
     int minZoomlevel() const override;
     int maxZoomlevel() const override;
+    double tilePixelRatio() const override;
     QString tilePosToUrl(const QGV::GeoTilePos& tilePos) const override;
 
 private:
     QString mUrl;
+    QVector<QGVUrlTemplate> mUrlTemplates;
+    int mServerNumber;
+    bool mRetinaTiles;
 };
@@ -19,8 +19,16 @@
 #pragma once
 
 #include "QGVLayer.h"
+#include "QGVTileIndex.h"
 
 #include <QElapsedTimer>
+#include <QImage>
+#include <QPointer>
+#include <QPolygonF>
+#include <QSet>
+#include <QTimer>
+
+class QGVImage;
 
 class QGV_LIB_DECL QGVLayerTiles : public QGVLayer
 {
@@ -28,6 +36,9 @@ class QGV_LIB_DECL QGVLayerTiles : public QGVLayer
 
 public:
     QGVLayerTiles();
+    ~QGVLayerTiles();
+
+    virtual QString getTilesId() const;
 
     void setTilesMarginWithZoomChange(size_t value);
     void setTilesMarginNoZoomChange(size_t value);
@@ -35,37 +46,106 @@ public:
     void setVisibleZoomLayersBelowCurrent(size_t value);
     void setVisibleZoomLayersAboveCurrent(size_t value);
     void setCameraUpdatesDuringAnimation(bool value);
+    void setPrefetchTilesBudget(size_t value);
+    void setPrefetchLookAheadMs(size_t value);
+    void setCompositeRendering(bool value);
+    void setParentTilesFallback(bool value);
+    void setOverzoomLevels(size_t value);
+    void setHiDpiSelection(bool value);
+    void setMaxTilesBytes(size_t value);
+    void setZoomHysteresis(double value);
+    void setZoomDwellMs(size_t value);
+    qint64 getUsedBytes() const;
 
 protected:
     void onProjection(QGVMap* geoMap) override;
     void onCamera(const QGVCameraState& oldState, const QGVCameraState& newState) override;
+    void onCameraPlan(const QList<QGVCameraState>& plan) override;
     void onUpdate() override;
     void onClean() override;
     void onTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj);
+    void onPrefetch(const QGV::GeoTilePos& tilePos, const QImage& image);
+    void onTileFailed(const QGV::GeoTilePos& tilePos);
 
     virtual int minZoomlevel() const = 0;
     virtual int maxZoomlevel() const = 0;
     virtual int scaleToZoom(double scale) const;
+    virtual double tilePixelRatio() const;
+    bool isHiDpiSelection() const;
     virtual void request(const QGV::GeoTilePos& tilePos) = 0;
     virtual void cancel(const QGV::GeoTilePos& tilePos) = 0;
+    virtual void reprioritize();
+    virtual bool prefetch(const QGV::GeoTilePos& tilePos);
+    virtual void cancelPrefetch(const QGV::GeoTilePos& tilePos);
+    qreal tilePriority(const QGV::GeoTilePos& tilePos) const;
+    QString tilesId() const;
+    void resetTilesId();
+    QGVImage* createImageTile(const QGV::GeoTilePos& tilePos, const QImage& image, const QString& source) const;
 
 private:
+    class Compositor;
+
+    int maxOverzoomlevel() const;
+    double fractionalZoom(double scale) const;
+    int stableZoom(double scale, int zoom);
     void processCamera();
+    bool isPlannedUpdate(const QGVCameraState& state) const;
+    void trackCamera(const QGVCameraState& state);
+    void updatePrefetch();
+    void prefetchCandidates(int zoom, const QRectF& projRect, QMultiMap<qreal, QGV::GeoTilePos>& result) const;
+    bool isPrefetchNeeded(const QGV::GeoTilePos& tilePos) const;
+    QRect tilesRect(int zoom, const QRectF& projRect) const;
+    bool isComposited(QGVDrawItem* tileObj) const;
+    void updateCompositor();
+    void paintTiles(QPainter* painter) const;
+    void paintFallback(QPainter* painter, const QGV::GeoTilePos& tilePos, const QRectF& paintRect) const;
+    void deleteDetachedTiles();
     void removeAllAbove(const QGV::GeoTilePos& tilePos);
     void removeWhenCovered(const QGV::GeoTilePos& tilePos);
     void removeForPerfomance(const QGV::GeoTilePos& tilePos);
+    void removeOverBudget();
+    qreal retentionScore(const QGV::GeoTilePos& tilePos) const;
+    static qint64 tileBytes(QGVDrawItem* tileObj);
     void addTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj);
     void removeTile(const QGV::GeoTilePos& tilePos);
+    void cacheTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj) const;
+    QGVDrawItem* restoreTile(const QGV::GeoTilePos& tilePos) const;
     bool isTileExists(const QGV::GeoTilePos& tilePos) const;
     bool isTileFinished(const QGV::GeoTilePos& tilePos) const;
-    QList<QGV::GeoTilePos> existingTiles(int zoom) const;
+    bool isTileInArea(const QGV::GeoTilePos& tilePos, const QPolygonF& area) const;
+    QImage sourceImage(const QGV::GeoTilePos& tilePos) const;
+    void requestOverzoom(const QGV::GeoTilePos& tilePos);
+    void cancelOverzoom(const QGV::GeoTilePos& tilePos);
+    void onOverzoomSource(const QGV::GeoTilePos& sourcePos, const QImage& image);
+    QGVImage* createOverzoomTile(const QGV::GeoTilePos& tilePos,
+                                 const QGV::GeoTilePos& sourcePos,
+                                 const QImage& image) const;
 
 private:
+    mutable QString mCachedTilesId;
     int mCurZoom;
     QRect mCurRect;
-    QMap<int, QMap<QGV::GeoTilePos, QGVDrawItem*>> mIndex;
+    QRect mVisibleRect;
+    QPolygonF mActiveArea;
+    QPolygonF mKeepArea;
+    QGVTileIndex mIndex;
+    QHash<QGV::GeoTilePos, quint64> mTileStamps;
+    quint64 mTick;
+    qint64 mUsedBytes;
 
     QElapsedTimer mLastAnimation;
+    QElapsedTimer mZoomDwell;
+    QTimer mZoomDwellTimer;
+    int mZoomCandidate;
+    QElapsedTimer mCameraClock;
+    QPointF mCameraCenter;
+    double mCameraScale;
+    QPointF mPanVelocity;
+    double mZoomVelocity;
+    QSet<QGV::GeoTilePos> mPrefetching;
+    QList<QGV::GeoTilePos> mPlannedTiles;
+    QMap<QGV::GeoTilePos, QSet<QGV::GeoTilePos>> mOverzoomSources;
+    QPointer<QGVDrawItem> mCompositor;
 
     struct
     {
@@ -75,5 +155,14 @@ private:
         bool CameraUpdatesDuringAnimation = true;
         size_t VisibleZoomLayersBelowCurrent = 10;
         size_t VisibleZoomLayersAboveCurrent = 10;
+        size_t PrefetchTilesBudget = 0;
+        size_t PrefetchLookAheadMs = 500;
+        bool CompositeRendering = false;
+        bool ParentTilesFallback = false;
+        size_t OverzoomLevels = 0;
+        bool HiDpiSelection = false;
+        size_t MaxTilesBytes = 0;
+        double ZoomHysteresis = 0;
+        size_t ZoomDwellMs = 0;
     } mPerfomanceProfile;
 };
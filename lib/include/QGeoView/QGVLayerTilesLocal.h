@@ -0,0 +1,69 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVLayerTiles.h"
+#include "QGVUrlTemplate.h"
+
+#include <QPointer>
+
+class QGVTileStore;
+
+/*!
+ * Tiles from local storage without network access.
+ * Tiles are read either from z/x/y directory tree or from tile pack file (QGVTileStore).
+ * Pack should be opened with QGVTileStore::Access::ReadOnly, then it is read in place and never modified.
+ * Files are memory-mapped and decoded in decoder threads.
+ */
+class QGV_LIB_DECL QGVLayerTilesLocal : public QGVLayerTiles
+{
+    Q_OBJECT
+
+public:
+    explicit QGVLayerTilesLocal(const QString& dirPath,
+                                const QString& filePattern = "${z}/${x}/${y}.png",
+                                int minZoom = 0,
+                                int maxZoom = 19);
+    explicit QGVLayerTilesLocal(QGVTileStore* store, const QString& tilesId, int minZoom = 0, int maxZoom = 19);
+    ~QGVLayerTilesLocal();
+
+    QString getTilesId() const override;
+    QString tilePosToFilePath(const QGV::GeoTilePos& tilePos) const;
+
+private:
+    int minZoomlevel() const override;
+    int maxZoomlevel() const override;
+    void request(const QGV::GeoTilePos& tilePos) override;
+    void cancel(const QGV::GeoTilePos& tilePos) override;
+    bool prefetch(const QGV::GeoTilePos& tilePos) override;
+    void cancelPrefetch(const QGV::GeoTilePos& tilePos) override;
+    void decodeTile(const QGV::GeoTilePos& tilePos);
+    void onTileDecoded(const QGV::GeoTilePos& tilePos, const QImage& image, const QString& source);
+    void removeDecoding(const QGV::GeoTilePos& tilePos);
+
+private:
+    QString mDirPath;
+    QGVUrlTemplate mFileTemplate;
+    QPointer<QGVTileStore> mStore;
+    QString mTilesId;
+    int mMinZoom;
+    int mMaxZoom;
+    QMap<QGV::GeoTilePos, quint64> mDecoding;
+    QSet<QGV::GeoTilePos> mPrefetch;
+};
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "QGVLayerTiles.h"
+#include "QGVUrlTemplate.h"
 
 #include <QNetworkReply>
 
@@ -27,17 +28,60 @@ class QGV_LIB_DECL QGVLayerTilesOnline : public QGVLayerTiles
     Q_OBJECT
 
 public:
+    QGVLayerTilesOnline();
     ~QGVLayerTilesOnline();
 
+    void setServerSharding(QGV::ServerSharding sharding);
+    QGV::ServerSharding getServerSharding() const;
+
 protected:
     virtual QString tilePosToUrl(const QGV::GeoTilePos& tilePos) const = 0;
+    virtual int metatileSize() const;
+    virtual QString metatileToUrl(const QGV::GeoTilePos& tilePos, const QSize& tiles) const;
+    QSize metatileTiles(const QGV::GeoTilePos& tilePos) const;
+    QGV::GeoRect metatileRect(const QGV::GeoTilePos& tilePos) const;
+    void restartRequests();
+    const QGVUrlTemplate& selectServer(const QGV::GeoTilePos& tilePos,
+                                       const QVector<QGVUrlTemplate>& servers,
+                                       int serverNumber) const;
 
 private:
     void request(const QGV::GeoTilePos& tilePos) override;
     void cancel(const QGV::GeoTilePos& tilePos) override;
-    void onReplyFinished(QNetworkReply* reply, const QGV::GeoTilePos& tilePos);
-    void removeReply(const QGV::GeoTilePos& tilePos);
+    void reprioritize() override;
+    bool prefetch(const QGV::GeoTilePos& tilePos) override;
+    void cancelPrefetch(const QGV::GeoTilePos& tilePos) override;
+    bool isPending(const QGV::GeoTilePos& tilePos) const;
+    QGV::GeoTilePos metatilePos(const QGV::GeoTilePos& tilePos) const;
+    qreal metatilePriority(const QGV::GeoTilePos& metaPos) const;
+    QString storeId() const;
+    void addWaiter(const QGV::GeoTilePos& tilePos);
+    void deliverTile(const QGV::GeoTilePos& tilePos, const QImage& image, const QString& source);
+    void deliverMetatile(const QGV::GeoTilePos& metaPos, const QImage& image, const QString& source);
+    QImage sliceMetatile(const QGV::GeoTilePos& metaPos, const QImage& image, const QGV::GeoTilePos& tilePos) const;
+    bool requestFromStore(const QGV::GeoTilePos& metaPos);
+    void requestFromNetwork(const QGV::GeoTilePos& metaPos);
+    void onDownloaded(const QGV::GeoTilePos& metaPos,
+                      const QUrl& url,
+                      QNetworkReply::NetworkError error,
+                      const QByteArray& rawImage);
+    void onDownloadFailed(const QGV::GeoTilePos& metaPos);
+    void decodeTile(const QGV::GeoTilePos& metaPos,
+                    const QByteArray& rawImage,
+                    const QString& source,
+                    bool fromNetwork);
+    void onTileDecoded(const QGV::GeoTilePos& metaPos,
+                       const QImage& image,
+                       const QByteArray& rawImage,
+                       const QString& source,
+                       bool fromNetwork);
+    void removeDownload(const QGV::GeoTilePos& metaPos);
+    void removeDecoding(const QGV::GeoTilePos& metaPos);
 
 private:
-    QMap<QGV::GeoTilePos, QNetworkReply*> mRequest;
+    QGV::ServerSharding mServerSharding;
+    QMap<QGV::GeoTilePos, QSet<QGV::GeoTilePos>> mWaiters;
+    QMap<QGV::GeoTilePos, quint64> mDownloads;
+    QMap<QGV::GeoTilePos, quint64> mDecoding;
+    QSet<QGV::GeoTilePos> mPrefetch;
 };
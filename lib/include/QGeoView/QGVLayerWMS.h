@@ -0,0 +1,69 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVLayer.h"
+#include "QGVUrlTemplate.h"
+
+#include <QNetworkReply>
+#include <QTimer>
+
+class QGVImage;
+
+/*!
+ * WMS layer which requests one image for whole viewport instead of tiles.
+ * Image is requested at device resolution when camera settles, previous image is shown during interaction.
+ * Url should contain lonLeft, latBottom, lonRight, latTop, WIDTH and HEIGHT placeholders.
+ */
+class QGV_LIB_DECL QGVLayerWMS : public QGVLayer
+{
+    Q_OBJECT
+
+public:
+    explicit QGVLayerWMS(const QString& url);
+    ~QGVLayerWMS();
+
+    void setUrl(const QString& url);
+    QString getUrl() const;
+    void setUpdateDelay(int msec);
+    int getUpdateDelay() const;
+
+protected:
+    virtual QString viewToUrl(const QGV::GeoRect& geoRect, const QSize& size) const;
+
+    void onProjection(QGVMap* geoMap) override;
+    void onCamera(const QGVCameraState& oldState, const QGVCameraState& newState) override;
+
+private:
+    void onMapState(QGV::MapState state);
+    void request();
+    void cancel();
+    void onDownloaded(const QGV::GeoRect& geoRect, QNetworkReply::NetworkError error, const QByteArray& rawImage);
+    void onImageDecoded(const QGV::GeoRect& geoRect, const QImage& image);
+
+private:
+    QString mUrl;
+    QGVUrlTemplate mUrlTemplate;
+    QTimer mTimer;
+    QGV::MapState mMapState;
+    QGVImage* mImage;
+    QString mLastUrl;
+    quint64 mDownload;
+    quint64 mDecoding;
+};
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <QMimeData>
+#include <QTimer>
 #include <QWidget>
 
 #include "QGVCamera.h"
@@ -30,6 +31,7 @@ class QGVDrawItem;
 class QGVWidget;
 class QGVMapQGScene;
 class QGVMapQGView;
+class QGVSpatialIndex;
 
 class QGV_LIB_DECL QGVMap : public QWidget
 {
@@ -54,9 +56,12 @@ public:
 
     QGVItem* rootItem() const;
     QGVMapQGView* geoView() const;
+    QGVSpatialIndex* spatialIndex() const;
 
     void addItem(QGVItem* item);
     void removeItem(QGVItem* item);
+    void addItems(const QList<QGVItem*>& items);
+    void removeItems(const QList<QGVItem*>& items);
     void deleteItems();
     int countItems() const;
     QGVItem* getItem(int index) const;
@@ -75,18 +80,24 @@ public:
     QList<QGVDrawItem*> search(const QPointF& projPos, Qt::ItemSelectionMode mode = Qt::ContainsItemShape) const;
     QList<QGVDrawItem*> search(const QRectF& projRect, Qt::ItemSelectionMode mode = Qt::ContainsItemShape) const;
     QList<QGVDrawItem*> search(const QPolygonF& projPolygon, Qt::ItemSelectionMode mode = Qt::ContainsItemShape) const;
+    QList<QGVDrawItem*> searchNearest(const QPointF& projPos, int count = 1) const;
 
     QPixmap grabMapView(bool includeWidgets = true) const;
 
     QPointF mapToProj(QPoint pos);
     QPoint mapFromProj(QPointF projPos);
 
+    void setDeferredUpdates(bool enabled);
+    bool isDeferredUpdates() const;
+    void flushUpdates();
+
     void refreshMap();
     void refreshProjection();
     void anchoreWidgets();
 
     virtual void onMapState(QGV::MapState state);
     virtual void onMapCamera(const QGVCameraState& oldState, const QGVCameraState& newState);
+    virtual void onMapCameraPlan(const QList<QGVCameraState>& plan);
 
 protected:
     void mouseMoveEvent(QMouseEvent* event) override;
@@ -107,11 +118,21 @@ Q_SIGNALS:
     void mapMouseDoubleClicked(QPointF projPos);
     void dropOnMap(QGV::GeoPos pos, const QMimeData* data);
 
+private:
+    friend class QGVItem;
+    void scheduleUpdate(QGVItem* item);
+    void cancelUpdate(QGVItem* item);
+
 private:
     QScopedPointer<QGVProjection> mProjection;
+    QScopedPointer<QGVSpatialIndex> mSpatialIndex;
     QScopedPointer<QGVMapQGView> mQGView;
     QScopedPointer<QGVItem> mRootItem;
     QList<QGVWidget*> mWidgets;
     QSet<QGVItem*> mSelections;
+    bool mDeferredUpdates;
+    bool mFlushing;
+    QSet<QGVItem*> mDirtyItems;
+    QTimer mUpdateTimer;
     void handleDropDataOnQGVMapQGView(QPointF position, const QMimeData* dropData);
 };
@@ -0,0 +1,91 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QHash>
+#include <QRectF>
+#include <QSet>
+#include <QVector>
+
+class QGVDrawItem;
+
+/*!
+ * R-tree of draw item bounds in projection coordinates.
+ * New and changed items are collected and packed by bulk loading (sort-tile-recursive)
+ * when many of them are queued, otherwise they are inserted one by one on next query.
+ */
+class QGV_LIB_DECL QGVSpatialIndex
+{
+public:
+    QGVSpatialIndex();
+
+    void load(const QVector<QPair<QGVDrawItem*, QRectF>>& items);
+    void insert(QGVDrawItem* item, const QRectF& projRect);
+    void remove(QGVDrawItem* item);
+    void clear();
+
+    bool contains(QGVDrawItem* item) const;
+    QRectF bounds(QGVDrawItem* item) const;
+    int count() const;
+
+    QList<QGVDrawItem*> search(const QPointF& projPos);
+    QList<QGVDrawItem*> search(const QRectF& projRect);
+    QList<QGVDrawItem*> nearest(const QPointF& projPos, int count);
+
+private:
+    struct Node
+    {
+        QRectF rect;
+        int parent;
+        bool leaf;
+        QVector<int> children;
+    };
+    struct Entry
+    {
+        QRectF rect;
+        QGVDrawItem* item;
+        int node;
+    };
+
+    int newNode(bool leaf);
+    void freeNode(int node);
+    QRectF childRect(int node, int child) const;
+    void attachChild(int node, int child);
+    void recalc(int node);
+    void tighten(int node);
+    int chooseLeaf(const QRectF& rect) const;
+    int split(int node);
+    void insertEntry(int entry);
+    void removeEntry(int entry);
+    QVector<int> pack(QVector<int> children, bool leaf);
+    void build();
+    void flush();
+
+private:
+    Q_DISABLE_COPY(QGVSpatialIndex)
+    int mRoot;
+    QVector<Node> mNodes;
+    QVector<int> mFreeNodes;
+    QVector<Entry> mEntries;
+    QVector<int> mFreeEntries;
+    QHash<QGVDrawItem*, int> mItems;
+    QSet<int> mPending;
+};
@@ -0,0 +1,57 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QCache>
+#include <QImage>
+
+/*!
+ * In-memory LRU cache of decoded tile images shared by all tile layers.
+ * Cache is limited by total pixel bytes and must be used from GUI thread only.
+ */
+class QGV_LIB_DECL QGVTileCache
+{
+public:
+    QGVTileCache();
+
+    void setMaxBytes(qint64 maxBytes);
+    qint64 getMaxBytes() const;
+    qint64 getUsedBytes() const;
+    int count() const;
+
+    bool contains(const QString& layerId, const QGV::GeoTilePos& tilePos) const;
+    QImage find(const QString& layerId, const QGV::GeoTilePos& tilePos);
+    QImage peek(const QString& layerId, const QGV::GeoTilePos& tilePos) const;
+    void insert(const QString& layerId, const QGV::GeoTilePos& tilePos, const QImage& image);
+    void remove(const QString& layerId, const QGV::GeoTilePos& tilePos);
+    void clear();
+
+    quint64 hits() const;
+    quint64 misses() const;
+    void resetCounters();
+
+private:
+    Q_DISABLE_COPY(QGVTileCache)
+    typedef QPair<QString, QGV::GeoTilePos> Key;
+    QCache<Key, QImage> mCache;
+    quint64 mHits;
+    quint64 mMisses;
+};
@@ -0,0 +1,69 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QThreadPool>
+
+#include <functional>
+
+/*!
+ * Decodes raw tile images or memory-mapped tile files in worker threads and delivers result to GUI thread.
+ * Number of concurrent decodes is limited by thread count. Results of cancelled tickets are dropped.
+ */
+class QGV_LIB_DECL QGVTileDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void(const QImage& image)> Callback;
+
+    explicit QGVTileDecoder(QObject* parent = nullptr);
+    ~QGVTileDecoder();
+
+    void setMaxThreads(int count);
+    int getMaxThreads() const;
+    int count() const;
+
+    quint64 decode(const QByteArray& rawData, const Callback& callback);
+    quint64 decodeFile(const QString& filePath, const Callback& callback);
+    void cancel(quint64 ticket);
+
+Q_SIGNALS:
+    void decoded(quint64 ticket, QImage image);
+
+private:
+    class Task;
+
+    quint64 start(Task* task, const Callback& callback);
+    bool isActive(quint64 ticket) const;
+    void onDecoded(quint64 ticket, const QImage& image);
+
+private:
+    Q_DISABLE_COPY(QGVTileDecoder)
+    quint64 mTicket;
+    mutable QMutex mMutex;
+    QHash<quint64, Callback> mCallbacks;
+    QThreadPool mPool;
+};
@@ -0,0 +1,86 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QUrl>
+
+#include <functional>
+
+/*!
+ * Downloads tiles for all online layers.
+ * Requests for the same url are merged into one network request, failed urls are not requested
+ * again until backoff time (growing exponentially with each failure) is passed, get() returns 0 for them.
+ * Network requests are started by QGVTileScheduler.
+ */
+class QGV_LIB_DECL QGVTileDownloader : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void(QNetworkReply::NetworkError error, const QByteArray& rawData)> Callback;
+
+    explicit QGVTileDownloader(QObject* parent = nullptr);
+    ~QGVTileDownloader();
+
+    void setBackoffMs(qint64 initialMs, qint64 maxMs);
+    int count() const;
+    bool isBackoff(const QUrl& url) const;
+
+    quint64 get(const QUrl& url, qreal priority, const Callback& callback);
+    void reprioritize(quint64 ticket, qreal priority);
+    void cancel(quint64 ticket);
+
+private:
+    struct Job
+    {
+        QUrl url;
+        quint64 schedule;
+        QPointer<QNetworkReply> reply;
+        QHash<quint64, Callback> waiters;
+        QHash<quint64, qreal> priorities;
+    };
+    struct Failure
+    {
+        int count;
+        qint64 retryAt;
+    };
+
+    void start(const QString& key);
+    void onFinished(const QString& key, QNetworkReply* reply);
+    void onFailure(const QString& key);
+    void updatePriority(const Job& job);
+    void abort(Job& job);
+
+private:
+    Q_DISABLE_COPY(QGVTileDownloader)
+    qint64 mBackoffInitialMs;
+    qint64 mBackoffMaxMs;
+    quint64 mTicket;
+    QElapsedTimer mClock;
+    QHash<QString, Job> mJobs;
+    QHash<quint64, QString> mTickets;
+    QHash<QString, Failure> mFailures;
+};
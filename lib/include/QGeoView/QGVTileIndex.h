@@ -0,0 +1,72 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QHash>
+#include <QMap>
+#include <QVarLengthArray>
+
+class QGVDrawItem;
+
+/*!
+ * Index of tiles keyed by packed 64-bit code: zoom in high 6 bits and Morton code of (x, y) below.
+ * Point lookups go through hash in constant time. Keys are also kept ordered, so descendants of tile
+ * on each zoom level form a contiguous key range and ancestors are found by hash lookup.
+ */
+class QGV_LIB_DECL QGVTileIndex
+{
+public:
+    typedef QVarLengthArray<QGV::GeoTilePos, 256> TileList;
+
+    static const int MaxZoom = 29;
+
+    static quint64 toKey(const QGV::GeoTilePos& tilePos);
+    static QGV::GeoTilePos fromKey(quint64 key);
+
+    QGVTileIndex();
+
+    bool isEmpty() const;
+    int count() const;
+    int count(int zoom) const;
+    bool contains(const QGV::GeoTilePos& tilePos) const;
+    QGVDrawItem* value(const QGV::GeoTilePos& tilePos) const;
+    void insert(const QGV::GeoTilePos& tilePos, QGVDrawItem* item);
+    QGVDrawItem* take(const QGV::GeoTilePos& tilePos);
+    void clear();
+
+    void tiles(int zoom, TileList& result) const;
+    void descendants(const QGV::GeoTilePos& tilePos, int fromZoom, int toZoom, TileList& result) const;
+    void ancestors(const QGV::GeoTilePos& tilePos, int fromZoom, TileList& result) const;
+
+    template<typename Func>
+    void forEach(Func func) const
+    {
+        for (auto it = mOrdered.constBegin(); it != mOrdered.constEnd(); ++it) {
+            func(fromKey(it.key()), it.value());
+        }
+    }
+
+private:
+    QHash<quint64, QGVDrawItem*> mItems;
+    QMap<quint64, QGVDrawItem*> mOrdered;
+    int mZoomCount[MaxZoom + 1];
+};
@@ -0,0 +1,76 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QHash>
+#include <QMap>
+#include <QTimer>
+
+#include <functional>
+
+/*!
+ * Queue of tile requests shared by all tile layers.
+ * Requests are started in priority order (lower value first) while number of requests in flight
+ * for the host is below the limit. Requests not started yet can be re-prioritized or dropped for free.
+ */
+class QGV_LIB_DECL QGVTileScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void()> Start;
+
+    explicit QGVTileScheduler(QObject* parent = nullptr);
+
+    void setMaxRequestsPerHost(int count);
+    int getMaxRequestsPerHost() const;
+    int queued() const;
+    int queued(const QString& host) const;
+    int inFlight(const QString& host) const;
+
+    quint64 enqueue(const QString& host, qreal priority, const Start& start);
+    void reprioritize(quint64 ticket, qreal priority);
+    bool isStarted(quint64 ticket) const;
+    void finish(quint64 ticket);
+
+private:
+    typedef QPair<qreal, quint64> Rank;
+    struct Request
+    {
+        QString host;
+        qreal priority;
+        bool started;
+        Start start;
+    };
+
+    void scheduleDispatch();
+    void dispatch();
+
+private:
+    Q_DISABLE_COPY(QGVTileScheduler)
+    int mMaxRequestsPerHost;
+    quint64 mTicket;
+    QTimer mDispatchTimer;
+    QHash<quint64, Request> mRequests;
+    QHash<QString, QMap<Rank, quint64>> mQueues;
+    QHash<QString, int> mInFlight;
+};
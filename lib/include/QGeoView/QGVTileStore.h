@@ -0,0 +1,107 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QThreadPool>
+
+/*!
+ * Persistent tile storage in one memory-mapped pack file.
+ * Raw tile data is indexed by (layer, zoom, x, y) and evicted in LRU order when
+ * the pack grows over the byte budget. Writes are done by a background thread.
+ * Read-only store never modifies the pack and returns loaded data in place from the mapped
+ * file, such data stays valid while the store exists.
+ */
+class QGV_LIB_DECL QGVTileStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Access
+    {
+        ReadWrite,
+        ReadOnly,
+    };
+
+    explicit QGVTileStore(const QString& filePath, QObject* parent = nullptr);
+    QGVTileStore(const QString& filePath, Access access, QObject* parent = nullptr);
+    ~QGVTileStore();
+
+    QString getFilePath() const;
+    bool isReadOnly() const;
+
+    void setMaxBytes(qint64 maxBytes);
+    qint64 getMaxBytes() const;
+    qint64 getUsedBytes() const;
+    int count() const;
+
+    bool contains(const QString& layerId, const QGV::GeoTilePos& tilePos) const;
+    QByteArray load(const QString& layerId, const QGV::GeoTilePos& tilePos);
+    void save(const QString& layerId, const QGV::GeoTilePos& tilePos, const QByteArray& rawData);
+    void flush();
+    void clear();
+
+private:
+    class Writer;
+    typedef QPair<quint64, quint64> Key;
+    struct Entry
+    {
+        qint64 offset;
+        quint32 size;
+        quint64 stamp;
+    };
+
+    static Key makeKey(const QString& layerId, const QGV::GeoTilePos& tilePos);
+    void open();
+    void openReadOnly();
+    void scan();
+    bool remap(qint64 size);
+    void unmap();
+    void touch(const Key& key, Entry& entry);
+    void evict();
+    void scheduleWrite();
+    void writePending();
+    void compact();
+
+private:
+    Q_DISABLE_COPY(QGVTileStore)
+    QString mFilePath;
+    bool mReadOnly;
+    qint64 mMaxBytes;
+    qint64 mUsedBytes;
+    qint64 mDeadBytes;
+    quint64 mTick;
+    bool mWriteScheduled;
+    mutable QMutex mMutex;
+    QFile mWriter;
+    QFile mReader;
+    uchar* mMap;
+    qint64 mMapSize;
+    QHash<Key, Entry> mIndex;
+    QMap<quint64, Key> mLru;
+    QHash<Key, QByteArray> mPending;
+    QHash<qint64, quint64> mTouched;
+    QList<qint64> mDeleted;
+    QThreadPool mPool;
+};
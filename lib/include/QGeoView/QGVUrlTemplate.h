@@ -0,0 +1,92 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#pragma once
+
+#include "QGVGlobal.h"
+
+#include <QSize>
+#include <QVector>
+
+/*!
+ * Url template parsed once into list of segments.
+ * Supported placeholders are ${x}, ${y}, ${z}, ${qk} (quad key), ${lcl} (locale), ${r} (@2x suffix).
+ * WMS-like lonLeft, latBottom, lonRight, latTop, WIDTH, HEIGHT are replaced only when WMS fields are enabled.
+ * Expanding into buffer with reserved capacity does not allocate.
+ */
+class QGV_LIB_DECL QGVUrlTemplate
+{
+public:
+    enum class Field
+    {
+        Text,
+        X,
+        Y,
+        Zoom,
+        QuadKey,
+        Locale,
+        Retina,
+        LonLeft,
+        LatBottom,
+        LonRight,
+        LatTop,
+        Width,
+        Height,
+    };
+
+    QGVUrlTemplate();
+    explicit QGVUrlTemplate(const QString& pattern, bool wmsFields = false);
+
+    void setPattern(const QString& pattern);
+    QString getPattern() const;
+    void setWmsFields(bool enabled);
+    bool isWmsFields() const;
+    void setLocale(const QString& locale);
+    QString getLocale() const;
+    void setRetina(bool enabled);
+    bool isRetina() const;
+    QString getHost() const;
+
+    bool isEmpty() const;
+    bool hasField(Field field) const;
+    bool hasGeoRect() const;
+    int sizeHint() const;
+
+    QString expand(const QGV::GeoTilePos& tilePos) const;
+    QString expand(const QGV::GeoTilePos& tilePos, const QGV::GeoRect& geoRect, const QSize& size) const;
+    void expand(QString& out, const QGV::GeoTilePos& tilePos, const QGV::GeoRect& geoRect, const QSize& size) const;
+
+private:
+    struct Segment
+    {
+        Field field;
+        int from;
+        int length;
+    };
+
+    void parse();
+
+private:
+    QString mPattern;
+    QString mLocale;
+    QString mHost;
+    QVector<Segment> mSegments;
+    int mFields;
+    bool mWmsFields;
+    bool mRetina;
+};
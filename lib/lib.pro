@@ -16,14 +16,25 @@ HEADERS += \
     $$PWD/include/QGeoView/QGVLayerGoogle.h \
     $$PWD/include/QGeoView/QGVLayerOSM.h \
     $$PWD/include/QGeoView/QGVLayerBDGEx.h \
+    $$PWD/include/QGeoView/QGVLayerFeatures.h \
     $$PWD/include/QGeoView/QGVLayerTiles.h \
+    $$PWD/include/QGeoView/QGVLayerTilesLocal.h \
     $$PWD/include/QGeoView/QGVLayerTilesOnline.h \
+    $$PWD/include/QGeoView/QGVLayerWMS.h \
     $$PWD/include/QGeoView/QGVMap.h \
     $$PWD/include/QGeoView/QGVMapQGItem.h \
     $$PWD/include/QGeoView/QGVMapQGView.h \
     $$PWD/include/QGeoView/QGVMapRubberBand.h \
     $$PWD/include/QGeoView/QGVProjection.h \
     $$PWD/include/QGeoView/QGVProjectionEPSG3857.h \
+    $$PWD/include/QGeoView/QGVSpatialIndex.h \
+    $$PWD/include/QGeoView/QGVTileCache.h \
+    $$PWD/include/QGeoView/QGVTileDecoder.h \
+    $$PWD/include/QGeoView/QGVTileDownloader.h \
+    $$PWD/include/QGeoView/QGVTileIndex.h \
+    $$PWD/include/QGeoView/QGVTileScheduler.h \
+    $$PWD/include/QGeoView/QGVTileStore.h \
+    $$PWD/include/QGeoView/QGVUrlTemplate.h \
     $$PWD/include/QGeoView/QGVWidget.h \
     $$PWD/include/QGeoView/QGVWidgetCompass.h \
     $$PWD/include/QGeoView/QGVWidgetScale.h \
@@ -43,14 +54,25 @@ SOURCES += \
     $$PWD/src/QGVLayerGoogle.cpp \
     $$PWD/src/QGVLayerOSM.cpp \
     $$PWD/src/QGVLayerBDGEx.cpp \
+    $$PWD/src/QGVLayerFeatures.cpp \
     $$PWD/src/QGVLayerTiles.cpp \
+    $$PWD/src/QGVLayerTilesLocal.cpp \
     $$PWD/src/QGVLayerTilesOnline.cpp \
+    $$PWD/src/QGVLayerWMS.cpp \
     $$PWD/src/QGVMap.cpp \
     $$PWD/src/QGVMapQGItem.cpp \
     $$PWD/src/QGVMapQGView.cpp \
     $$PWD/src/QGVMapRubberBand.cpp \
     $$PWD/src/QGVProjection.cpp \
     $$PWD/src/QGVProjectionEPSG3857.cpp \
+    $$PWD/src/QGVSpatialIndex.cpp \
+    $$PWD/src/QGVTileCache.cpp \
+    $$PWD/src/QGVTileDecoder.cpp \
+    $$PWD/src/QGVTileDownloader.cpp \
+    $$PWD/src/QGVTileIndex.cpp \
+    $$PWD/src/QGVTileScheduler.cpp \
+    $$PWD/src/QGVTileStore.cpp \
+    $$PWD/src/QGVUrlTemplate.cpp \
     $$PWD/src/QGVWidget.cpp \
     $$PWD/src/QGVWidgetCompass.cpp \
     $$PWD/src/QGVWidgetScale.cpp \
@@ -26,6 +26,22 @@ QGVCameraState::QGVCameraState(QGVMap* geoMap, double azimuth, double scale, con
     , mScale(scale)
     , mAzimuth(azimuth)
     , mProjRect(projRect)
+    , mProjPolygon(projRect)
+    , mAnimation(animation)
+{
+    Q_ASSERT(geoMap);
+}
+
+QGVCameraState::QGVCameraState(QGVMap* geoMap,
+                               double azimuth,
+                               double scale,
+                               const QPolygonF& projPolygon,
+                               bool animation)
+    : mGeoMap(geoMap)
+    , mScale(scale)
+    , mAzimuth(azimuth)
+    , mProjRect(projPolygon.boundingRect())
+    , mProjPolygon(projPolygon)
     , mAnimation(animation)
 {
     Q_ASSERT(geoMap);
@@ -36,6 +52,7 @@ QGVCameraState::QGVCameraState(const QGVCameraState& other)
     , mScale(other.mScale)
     , mAzimuth(other.mAzimuth)
     , mProjRect(other.mProjRect)
+    , mProjPolygon(other.mProjPolygon)
     , mAnimation(other.mAnimation)
 {
 }
@@ -45,6 +62,7 @@ QGVCameraState::QGVCameraState(const QGVCameraState&& other)
     , mScale(std::move(other.mScale))
     , mAzimuth(std::move(other.mAzimuth))
     , mProjRect(std::move(other.mProjRect))
+    , mProjPolygon(std::move(other.mProjPolygon))
     , mAnimation(std::move(other.mAnimation))
 {
 }
@@ -55,6 +73,7 @@ QGVCameraState& QGVCameraState::operator=(const QGVCameraState& other)
     mScale = other.mScale;
     mAzimuth = other.mAzimuth;
     mProjRect = other.mProjRect;
+    mProjPolygon = other.mProjPolygon;
     mAnimation = other.mAnimation;
     return *this;
 }
@@ -65,6 +84,7 @@ QGVCameraState& QGVCameraState::operator=(const QGVCameraState&& other)
     mScale = std::move(other.mScale);
     mAzimuth = std::move(other.mAzimuth);
     mProjRect = std::move(other.mProjRect);
+    mProjPolygon = std::move(other.mProjPolygon);
     mAnimation = std::move(other.mAnimation);
     return *this;
 }
@@ -94,6 +114,11 @@ QRectF QGVCameraState::projRect() const
     return mProjRect;
 }
 
+QPolygonF QGVCameraState::projPolygon() const
+{
+    return mProjPolygon;
+}
+
 QPointF QGVCameraState::projCenter() const
 {
     return mProjRect.center();
@@ -242,6 +267,23 @@ void QGVCameraAnimation::onStop()
 {
 }
 
+QList<QGVCameraState> QGVCameraAnimation::plan(int samples)
+{
+    const QGVCameraState& origin = mActions.origin();
+    QList<QGVCameraState> result;
+    for (int i = 1; i <= samples; ++i) {
+        const double progress = static_cast<double>(i) / samples;
+        QGVCameraActions target(mActions);
+        target.reset();
+        onProgress(progress, target);
+        const double factor = origin.scale() / target.scale();
+        QRectF projRect(QPointF(0, 0), origin.projRect().size() * factor);
+        projRect.moveCenter(target.projCenter());
+        result.append(QGVCameraState(origin.getMap(), target.azimuth(), target.scale(), projRect, true));
+    }
+    return result;
+}
+
 double QGVCameraAnimation::interpolateScale(double from, double to, double progress)
 {
     if (qFuzzyCompare(from, to)) {
@@ -347,6 +389,12 @@ void QGVCameraFlyAnimation::onStart()
     }
     mFlyScale = qMin(actions().scale(), expectedSpeed / projSpeed0);
     mFlyAnchor = interpolatePos(actions().origin().projCenter(), actions().projCenter(), 0.5);
+    actions().origin().getMap()->onMapCameraPlan(plan(16));
+}
+
+void QGVCameraFlyAnimation::onStop()
+{
+    actions().origin().getMap()->onMapCameraPlan({});
 }
 
 void QGVCameraFlyAnimation::onProgress(double progress, QGVCameraActions& target)
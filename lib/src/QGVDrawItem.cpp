@@ -19,6 +19,7 @@
 #include "QGVDrawItem.h"
 #include "QGVMapQGItem.h"
 #include "QGVMapQGView.h"
+#include "QGVSpatialIndex.h"
 
 namespace {
 double highlightScale = 1.15;
@@ -26,15 +27,28 @@ double highlightScale = 1.15;
 
 QGVDrawItem::QGVDrawItem()
     : mDirty{ false }
+    , mIndexDirty{ true }
+    , mIndex{ nullptr }
 {
 }
 
+QGVDrawItem::~QGVDrawItem()
+{
+    removeIndex();
+}
+
 void QGVDrawItem::setFlags(QGV::ItemFlags flags)
 {
     if (mFlags != flags) {
         mFlags = flags;
+        mIndexDirty = true;
         projOnFlags();
-        refresh();
+        auto geoMap = getMap();
+        if (geoMap != nullptr && geoMap->isDeferredUpdates()) {
+            update();
+        } else {
+            refresh();
+        }
     }
 }
 
@@ -95,10 +109,16 @@ void QGVDrawItem::refresh()
     mQGDrawItem->setOpacity(effectiveOpacity());
     mQGDrawItem->setZValue(effectiveZValue());
     mQGDrawItem->setAcceptHoverEvents(isFlag(QGV::ItemFlag::Highlightable));
+    mQGDrawItem->setCacheMode(isFlag(QGV::ItemFlag::NoCache) ? QGraphicsItem::NoCache
+                                                             : QGraphicsItem::DeviceCoordinateCache);
     mQGDrawItem->update();
 
     mDirty = false;
 
+    if (mIndexDirty || !userTransform.isIdentity() || !itemTransform.isIdentity()) {
+        updateIndex();
+    }
+
     if (QGV::isDrawDebug()) {
         setProperty("updateCount", property("updateCount").toInt() + 1);
     }
@@ -122,6 +142,8 @@ void QGVDrawItem::resetBoundary()
     if (!mQGDrawItem.isNull()) {
         mQGDrawItem->resetGeometry();
     }
+    mIndexDirty = true;
+    updateIndex();
 
     if (isFlag(QGV::ItemFlag::Transformed) || isFlag(QGV::ItemFlag::Highlighted) ||
         isFlag(QGV::ItemFlag::IgnoreScale) || isFlag(QGV::ItemFlag::IgnoreAzimuth)) {
@@ -196,6 +218,7 @@ void QGVDrawItem::projOnObjectMovePos(const QPointF& /*projPos*/)
 void QGVDrawItem::onProjection(QGVMap* geoMap)
 {
     QGVItem::onProjection(geoMap);
+    mIndexDirty = true;
     if (!mQGDrawItem.isNull()) {
         if (mQGDrawItem->scene() != geoMap->geoView()->scene()) {
             onClean();
@@ -228,5 +251,35 @@ void QGVDrawItem::onUpdate()
 void QGVDrawItem::onClean()
 {
     QGVItem::onClean();
+    removeIndex();
     mQGDrawItem.reset(nullptr);
 }
+
+void QGVDrawItem::updateIndex()
+{
+    auto geoMap = getMap();
+    if (mQGDrawItem.isNull() || geoMap == nullptr) {
+        return;
+    }
+    if (isFlag(QGV::ItemFlag::NoSearch)) {
+        removeIndex();
+        mIndexDirty = false;
+        return;
+    }
+    QGVSpatialIndex* index = geoMap->spatialIndex();
+    if (mIndex != index) {
+        removeIndex();
+        mIndex = index;
+    }
+    mIndex->insert(this, mQGDrawItem->sceneBoundingRect());
+    mIndexDirty = false;
+}
+
+void QGVDrawItem::removeIndex()
+{
+    if (mIndex != nullptr) {
+        mIndex->remove(this);
+        mIndex = nullptr;
+    }
+    mIndexDirty = true;
+}
@@ -18,7 +18,13 @@
 
 #include "QGVGlobal.h"
 #include "QGVMap.h"
+#include "QGVTileCache.h"
+#include "QGVTileDecoder.h"
+#include "QGVTileDownloader.h"
+#include "QGVTileScheduler.h"
 
+#include <QCoreApplication>
+#include <QPointer>
 #include <QTransform>
 #include <QtGlobal>
 #include <QtMath>
@@ -27,6 +33,7 @@ namespace {
 bool drawDebugEnabled = false;
 bool printDebugEnabled = false;
 QNetworkAccessManager* networkManager = nullptr;
+QGVTileStore* tileStore = nullptr;
 }
 
 namespace QGV {
@@ -310,6 +317,16 @@ bool GeoTilePos::operator<(const GeoTilePos& other) const
     return mPos.y() < other.mPos.y();
 }
 
+bool GeoTilePos::operator==(const GeoTilePos& other) const
+{
+    return mZoom == other.mZoom && mPos == other.mPos;
+}
+
+bool GeoTilePos::operator!=(const GeoTilePos& other) const
+{
+    return !(*this == other);
+}
+
 int GeoTilePos::zoom() const
 {
     return mZoom;
@@ -461,6 +478,60 @@ QNetworkAccessManager* getNetworkManager()
     return networkManager;
 }
 
+void setTileStore(QGVTileStore* store)
+{
+    tileStore = store;
+}
+
+QGVTileStore* getTileStore()
+{
+    return tileStore;
+}
+
+QGVTileCache* getTileCache()
+{
+    static QGVTileCache tileCache;
+    return &tileCache;
+}
+
+QGVTileDecoder* getTileDecoder()
+{
+    static QPointer<QGVTileDecoder> tileDecoder;
+    if (tileDecoder.isNull()) {
+        tileDecoder = new QGVTileDecoder(QCoreApplication::instance());
+    }
+    return tileDecoder.data();
+}
+
+QGVTileDownloader* getTileDownloader()
+{
+    static QPointer<QGVTileDownloader> tileDownloader;
+    if (tileDownloader.isNull()) {
+        tileDownloader = new QGVTileDownloader(QCoreApplication::instance());
+    }
+    return tileDownloader.data();
+}
+
+QGVTileScheduler* getTileScheduler()
+{
+    static QPointer<QGVTileScheduler> tileScheduler;
+    if (tileScheduler.isNull()) {
+        tileScheduler = new QGVTileScheduler(QCoreApplication::instance());
+    }
+    return tileScheduler.data();
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+size_t qHash(const GeoTilePos& key, size_t seed)
+#else
+uint qHash(const GeoTilePos& key, uint seed)
+#endif
+{
+    const quint64 value = (static_cast<quint64>(key.zoom()) << 58) ^ (static_cast<quint64>(key.pos().x()) << 29) ^
+                          static_cast<quint64>(key.pos().y());
+    return static_cast<decltype(seed)>(value ^ (value >> 32)) ^ seed;
+}
+
 } // namespace QGV
 
 QDebug operator<<(QDebug debug, const QGV::GeoPos& value)
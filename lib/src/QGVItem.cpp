@@ -17,23 +17,33 @@
  ****************************************************************************/
 
 #include "QGVItem.h"
+#include <QSet>
 #include <limits>
 
 QGVItem::QGVItem(QGVItem* parent)
 {
     mParent = parent;
+    mIndexInParent = -1;
+    mDeadChildren = 0;
     mZValue = 0;
     mOpacity = 1.0;
     mVisible = true;
     mSelectable = false;
     mSelected = false;
+    mUpdateMap = nullptr;
+    mEffectiveValid = false;
+    mEffectiveVisible = true;
+    mEffectiveOpacity = 1.0;
+    mEffectiveZValue = 0.0;
+    mEffectiveZScale = 1.0;
 }
 
 QGVItem::~QGVItem()
 {
     deleteItems();
+    cancelUpdate();
     if (mParent != nullptr) {
-        mParent->mChildrens.removeAll(this);
+        mParent->detachChild(this);
     }
 }
 
@@ -43,13 +53,15 @@ void QGVItem::setParent(QGVItem* item)
         return;
     }
     setSelected(false);
+    cancelUpdate();
     if (mParent != nullptr) {
-        mParent->mChildrens.removeAll(this);
+        mParent->detachChild(this);
     }
     auto oldParent = mParent;
     mParent = item;
+    invalidateEffective();
     if (mParent != nullptr) {
-        mParent->mChildrens.append(this);
+        mParent->attachChild(this);
     }
     auto geoMap = getMap();
     if (geoMap != nullptr) {
@@ -94,20 +106,108 @@ void QGVItem::removeItem(QGVItem* item)
     item->setParent(nullptr);
 }
 
+void QGVItem::addItems(const QList<QGVItem*>& items)
+{
+    QSet<QGVItem*> oldParents;
+    QList<QGVItem*> added;
+    added.reserve(items.size());
+    mChildrens.reserve(mChildrens.size() + items.size());
+    for (QGVItem* item : items) {
+        Q_ASSERT(item);
+        if (item->mParent == this) {
+            continue;
+        }
+        item->setSelected(false);
+        item->cancelUpdate();
+        if (item->mParent != nullptr) {
+            oldParents.insert(item->mParent);
+            item->mParent->detachChild(item);
+        }
+        item->mParent = this;
+        item->invalidateEffective();
+        attachChild(item);
+        added.append(item);
+    }
+    if (added.isEmpty()) {
+        return;
+    }
+    auto geoMap = getMap();
+    if (geoMap == nullptr) {
+        for (QGVItem* item : added) {
+            item->onClean();
+        }
+        return;
+    }
+    for (QGVItem* oldParent : oldParents) {
+        Q_EMIT geoMap->itemsChanged(oldParent);
+    }
+    Q_EMIT geoMap->itemsChanged(this);
+    for (QGVItem* item : added) {
+        item->onProjection(geoMap);
+    }
+    for (QGVItem* item : added) {
+        item->update();
+    }
+}
+
+void QGVItem::removeItems(const QList<QGVItem*>& items)
+{
+    QList<QGVItem*> removed;
+    removed.reserve(items.size());
+    for (QGVItem* item : items) {
+        Q_ASSERT(item);
+        if (item->mParent != this) {
+            continue;
+        }
+        item->setSelected(false);
+        item->cancelUpdate();
+        mChildrens[item->mIndexInParent] = nullptr;
+        item->mIndexInParent = -1;
+        item->mParent = nullptr;
+        item->invalidateEffective();
+        removed.append(item);
+    }
+    if (removed.isEmpty()) {
+        return;
+    }
+    mDeadChildren += removed.size();
+    compactChildren();
+    auto geoMap = getMap();
+    if (geoMap != nullptr) {
+        Q_EMIT geoMap->itemsChanged(this);
+    }
+    for (QGVItem* item : removed) {
+        item->onClean();
+    }
+}
+
+QList<QGVItem*> QGVItem::takeAll()
+{
+    compactChildren();
+    const auto items = mChildrens;
+    removeItems(items);
+    return items;
+}
+
 void QGVItem::deleteItems()
 {
-    auto copy = mChildrens;
-    qDeleteAll(copy.begin(), copy.end());
+    compactChildren();
+    const auto items = mChildrens;
     mChildrens.clear();
+    for (QGVItem* item : items) {
+        item->mIndexInParent = -1;
+    }
+    qDeleteAll(items.begin(), items.end());
 }
 
 int QGVItem::countItems() const
 {
-    return mChildrens.count();
+    return mChildrens.count() - mDeadChildren;
 }
 
 QGVItem* QGVItem::getItem(int index) const
 {
+    compactChildren();
     return mChildrens.at(index);
 }
 
@@ -115,6 +215,7 @@ void QGVItem::setZValue(qint16 zValue)
 {
     if (mZValue != zValue) {
         mZValue = zValue;
+        invalidateEffective();
         update();
     }
 }
@@ -126,13 +227,23 @@ qint16 QGVItem::getZValue() const
 
 void QGVItem::bringToFront()
 {
-    mZValue = std::numeric_limits<decltype(mZValue)>::max();
+    const auto zValue = std::numeric_limits<decltype(mZValue)>::max();
+    if (mZValue == zValue) {
+        return;
+    }
+    mZValue = zValue;
+    invalidateEffective();
     update();
 }
 
 void QGVItem::sendToBack()
 {
-    mZValue = std::numeric_limits<decltype(mZValue)>::min();
+    const auto zValue = std::numeric_limits<decltype(mZValue)>::min();
+    if (mZValue == zValue) {
+        return;
+    }
+    mZValue = zValue;
+    invalidateEffective();
     update();
 }
 
@@ -143,6 +254,7 @@ void QGVItem::setOpacity(double value)
         return;
     }
     mOpacity = value;
+    invalidateEffective();
     update();
 }
 
@@ -206,6 +318,7 @@ void QGVItem::setVisible(bool visible)
         return;
     }
     mVisible = visible;
+    invalidateEffective();
     update();
 }
 
@@ -226,59 +339,147 @@ void QGVItem::hide()
 
 double QGVItem::effectiveZValue() const
 {
-    if (mParent == nullptr) {
-        return mZValue;
-    }
-    const auto den = std::numeric_limits<decltype(mZValue)>::max() - std::numeric_limits<decltype(mZValue)>::min();
-    double range = 1.0;
-    for (QGVItem* obj = mParent->getParent(); obj != nullptr; obj = obj->getParent()) {
-        range *= 1.0 / den;
-    }
-    const double efZValue = range * mZValue / den;
-    return mParent->effectiveZValue() + efZValue;
+    validateEffective();
+    return mEffectiveZValue;
 }
 
 double QGVItem::effectiveOpacity() const
 {
-    if (mParent == nullptr) {
-        return mOpacity;
-    }
-    return mOpacity * mParent->effectiveOpacity();
+    validateEffective();
+    return mEffectiveOpacity;
 }
 
 bool QGVItem::effectivelyVisible() const
 {
-    if (mParent == nullptr) {
-        return mVisible;
-    }
-    return mVisible && mParent->effectivelyVisible();
+    validateEffective();
+    return mEffectiveVisible;
 }
 
 void QGVItem::update()
 {
-    if (getMap() == nullptr) {
+    auto geoMap = getMap();
+    if (geoMap == nullptr) {
         return;
     }
-    for (QGVItem* obj : mChildrens) {
-        obj->update();
+    if (geoMap->isDeferredUpdates() && !geoMap->mFlushing) {
+        if (mUpdateMap != geoMap) {
+            cancelUpdate();
+            mUpdateMap = geoMap;
+            geoMap->scheduleUpdate(this);
+        }
+        return;
     }
+    updateNow();
+}
+
+void QGVItem::updateNow()
+{
+    cancelUpdate();
+    forEachChild([](QGVItem* obj) { obj->updateNow(); });
     onUpdate();
 }
 
-void QGVItem::onProjection(QGVMap* geoMap)
+void QGVItem::cancelUpdate()
+{
+    // map which scheduled update is kept, item can be already detached from it
+    if (mUpdateMap == nullptr) {
+        return;
+    }
+    mUpdateMap->cancelUpdate(this);
+    mUpdateMap = nullptr;
+}
+
+void QGVItem::attachChild(QGVItem* item)
+{
+    item->mIndexInParent = mChildrens.size();
+    mChildrens.append(item);
+}
+
+void QGVItem::detachChild(QGVItem* item)
+{
+    // Slot is emptied in constant time, list is compacted later keeping insertion order
+    const int index = item->mIndexInParent;
+    if (index < 0 || index >= mChildrens.size() || mChildrens.at(index) != item) {
+        return;
+    }
+    mChildrens[index] = nullptr;
+    mDeadChildren++;
+    item->mIndexInParent = -1;
+    if (mDeadChildren * 2 > mChildrens.size()) {
+        compactChildren();
+    }
+}
+
+void QGVItem::compactChildren() const
+{
+    if (mDeadChildren == 0) {
+        return;
+    }
+    // One stable pass keeps order of remaining children
+    int count = 0;
+    for (int i = 0; i < mChildrens.size(); ++i) {
+        QGVItem* obj = mChildrens.at(i);
+        if (obj != nullptr) {
+            obj->mIndexInParent = count;
+            mChildrens[count++] = obj;
+        }
+    }
+    mChildrens.erase(mChildrens.begin() + count, mChildrens.end());
+    mDeadChildren = 0;
+}
+
+void QGVItem::invalidateEffective()
 {
-    for (QGVItem* obj : mChildrens) {
-        obj->onProjection(geoMap);
+    // Valid cache of child always means valid cache of parent
+    if (!mEffectiveValid) {
+        return;
+    }
+    mEffectiveValid = false;
+    forEachChild([](QGVItem* obj) { obj->invalidateEffective(); });
+}
+
+void QGVItem::validateEffective() const
+{
+    if (mEffectiveValid) {
+        return;
+    }
+    if (mParent == nullptr) {
+        mEffectiveVisible = mVisible;
+        mEffectiveOpacity = mOpacity;
+        mEffectiveZValue = mZValue;
+        mEffectiveZScale = 1.0;
+    } else {
+        mParent->validateEffective();
+        const auto den = std::numeric_limits<decltype(mZValue)>::max() - std::numeric_limits<decltype(mZValue)>::min();
+        mEffectiveVisible = mVisible && mParent->mEffectiveVisible;
+        mEffectiveOpacity = mOpacity * mParent->mEffectiveOpacity;
+        mEffectiveZScale = mParent->mEffectiveZScale / den;
+        mEffectiveZValue = mParent->mEffectiveZValue + mEffectiveZScale * mZValue;
     }
+    mEffectiveValid = true;
+}
+
+void QGVItem::onProjection(QGVMap* geoMap)
+{
+    forEachChild([geoMap](QGVItem* obj) { obj->onProjection(geoMap); });
 }
 
 void QGVItem::onCamera(const QGVCameraState& oldState, const QGVCameraState& newState)
 {
-    for (QGVItem* obj : mChildrens) {
+    forEachChild([&oldState, &newState](QGVItem* obj) {
         if (obj->isVisible()) {
             obj->onCamera(oldState, newState);
         }
-    }
+    });
+}
+
+void QGVItem::onCameraPlan(const QList<QGVCameraState>& plan)
+{
+    forEachChild([&plan](QGVItem* obj) {
+        if (obj->isVisible()) {
+            obj->onCameraPlan(plan);
+        }
+    });
 }
 
 void QGVItem::onUpdate()
@@ -287,7 +488,5 @@ void QGVItem::onUpdate()
 
 void QGVItem::onClean()
 {
-    for (QGVItem* obj : mChildrens) {
-        obj->onClean();
-    }
+    forEachChild([](QGVItem* obj) { obj->onClean(); });
 }
@@ -36,6 +36,8 @@ const QStringList URLTemplates = {
 
 QGVLayerBDGEx::QGVLayerBDGEx(int serverNumber)
     : mUrl(URLTemplates.value(serverNumber))
+    , mUrlTemplate(mUrl, true)
+    , mMetatileSize(1)
 {
     setName("Banco de Dados Geográfico do Exército");
     setDescription("Copyrights: \"Termo de Uso do BDGEx\"");
@@ -43,6 +45,8 @@ QGVLayerBDGEx::QGVLayerBDGEx(int serverNumber)
 
 QGVLayerBDGEx::QGVLayerBDGEx(const QString& url)
     : mUrl(url)
+    , mUrlTemplate(mUrl, true)
+    , mMetatileSize(1)
 {
     setName("Padrão");
     setDescription("Carta Topográfica Matricial");
@@ -51,6 +55,8 @@ QGVLayerBDGEx::QGVLayerBDGEx(const QString& url)
 void QGVLayerBDGEx::setUrl(const QString& url)
 {
     mUrl = url;
+    mUrlTemplate.setPattern(mUrl);
+    resetTilesId();
 }
 
 QString QGVLayerBDGEx::getUrl() const
@@ -58,6 +64,27 @@ QString QGVLayerBDGEx::getUrl() const
     return mUrl;
 }
 
+void QGVLayerBDGEx::setMetatileSize(int size)
+{
+    size = qMax(1, size);
+    if (mMetatileSize == size) {
+        return;
+    }
+    mMetatileSize = size;
+    restartRequests();
+    qgvDebug() << "MetatileSize changed to" << mMetatileSize;
+}
+
+int QGVLayerBDGEx::getMetatileSize() const
+{
+    return mMetatileSize;
+}
+
+QString QGVLayerBDGEx::getTilesId() const
+{
+    return mUrl;
+}
+
 int QGVLayerBDGEx::minZoomlevel() const
 {
     return 0;
@@ -70,18 +97,25 @@ int QGVLayerBDGEx::maxZoomlevel() const
 
 QString QGVLayerBDGEx::tilePosToUrl(const QGV::GeoTilePos& tilePos) const
 {
-    QString url = mUrl;
-    QGV::GeoRect rect = tilePos.toGeoRect();
-    url.replace("lonLeft", QString::number(rect.lonLeft(), 'f', 6));
-    url.replace("latBottom", QString::number(rect.latBottom(), 'f', 6));
-    url.replace("lonRight", QString::number(rect.lonRight(), 'f', 6));
-    url.replace("latTop", QString::number(rect.latTop(), 'f', 6));
+    return rectToUrl(tilePos.toGeoRect(), 1);
+}
+
+int QGVLayerBDGEx::metatileSize() const
+{
+    return mMetatileSize;
+}
+
+QString QGVLayerBDGEx::metatileToUrl(const QGV::GeoTilePos& tilePos, const QSize& tiles) const
+{
+    return rectToUrl(metatileRect(tilePos), tiles.width());
+}
+
+QString QGVLayerBDGEx::rectToUrl(const QGV::GeoRect& rect, int widthTiles) const
+{
     double m_width = rect.lonRight() - rect.lonLeft();
     double m_height = rect.latTop() - rect.latBottom();
     double ratio = m_width / m_height;
-    int width_pixels = 900;
+    int width_pixels = 900 * widthTiles;
     int height_pixels = (int)((double)width_pixels / ratio);
-    url.replace("WIDTH", QString::number(width_pixels));
-    url.replace("HEIGHT", QString::number(height_pixels));
-    return url;
+    return mUrlTemplate.expand({}, rect, QSize(width_pixels, height_pixels));
 }
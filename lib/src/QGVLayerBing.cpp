@@ -48,6 +48,7 @@ QGVLayerBing::QGVLayerBing(QGV::TilesType type, QLocale locale, int serverNumber
     , mServerNumber(serverNumber)
 {
     createName();
+    createUrlTemplate();
     setDescription("Copyrights ©Microsoft");
 }
 
@@ -55,12 +56,14 @@ void QGVLayerBing::setType(QGV::TilesType type)
 {
     mType = type;
     createName();
+    createUrlTemplate();
 }
 
 void QGVLayerBing::setLocale(const QLocale& locale)
 {
     mLocale = locale;
     createName();
+    createUrlTemplate();
 }
 
 QGV::TilesType QGVLayerBing::getType() const
@@ -85,6 +88,22 @@ void QGVLayerBing::createName()
     setName("Bing Maps (" + adapter[mType] + " " + mLocale.name() + ")");
 }
 
+void QGVLayerBing::createUrlTemplate()
+{
+    resetTilesId();
+    mUrlTemplates.clear();
+    for (const QString& url : URLTemplates[mType]) {
+        QGVUrlTemplate urlTemplate(url);
+        urlTemplate.setLocale(mLocale.name());
+        mUrlTemplates.append(urlTemplate);
+    }
+}
+
+QString QGVLayerBing::getTilesId() const
+{
+    return URLTemplates[mType].first() + "#" + mLocale.name();
+}
+
 int QGVLayerBing::minZoomlevel() const
 {
     return 1;
@@ -97,9 +116,5 @@ int QGVLayerBing::maxZoomlevel() const
 
 QString QGVLayerBing::tilePosToUrl(const QGV::GeoTilePos& tilePos) const
 {
-    const QStringList& list = URLTemplates[mType];
-    QString url = list.value(mServerNumber).toLower();
-    url.replace("${lcl}", mLocale.name());
-    url.replace("${qk}", tilePos.toQuadKey());
-    return url;
+    return selectServer(tilePos, mUrlTemplates, mServerNumber).expand(tilePos);
 }
@@ -0,0 +1,571 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVLayerFeatures.h"
+#include "QGVMapQGView.h"
+
+#include <QGraphicsItem>
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+const int maxGridSize = 1024;
+const double gridFeaturesPerCell = 16.0;
+const double gridLargeCells = 4.0;
+
+bool overlaps(const QRectF& rect1, const QRectF& rect2)
+{
+    return rect1.left() <= rect2.right() && rect2.left() <= rect1.right() && rect1.top() <= rect2.bottom() &&
+           rect2.top() <= rect1.bottom();
+}
+
+double segmentDistance(const QPointF& pos, const QPointF& pt1, const QPointF& pt2)
+{
+    const QPointF delta = pt2 - pt1;
+    const double length2 = QPointF::dotProduct(delta, delta);
+    double t = 0;
+    if (length2 > 0) {
+        t = qBound(0.0, QPointF::dotProduct(pos - pt1, delta) / length2, 1.0);
+    }
+    const QPointF diff = pos - (pt1 + t * delta);
+    return qSqrt(QPointF::dotProduct(diff, diff));
+}
+}
+
+class QGVLayerFeatures::Renderer : public QGraphicsItem
+{
+public:
+    explicit Renderer(QGVLayerFeatures* layer)
+        : mLayer(layer)
+    {
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+        setCacheMode(QGraphicsItem::NoCache);
+        setAcceptedMouseButtons(Qt::NoButton);
+    }
+
+    void setRect(const QRectF& rect)
+    {
+        if (mRect != rect) {
+            prepareGeometryChange();
+            mRect = rect;
+        }
+    }
+
+    QRectF boundingRect() const override final
+    {
+        return mRect;
+    }
+
+    QPainterPath shape() const override final
+    {
+        // Features are not hit by mouse as scene items
+        return {};
+    }
+
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* /*widget*/) override final
+    {
+        mLayer->paintFeatures(painter, option->exposedRect);
+    }
+
+private:
+    QGVLayerFeatures* mLayer;
+    QRectF mRect;
+};
+
+QGVLayerFeatures::QGVLayerFeatures()
+    : mProjection(nullptr)
+    , mGridDirty(true)
+    , mGridSize(0)
+{
+    setName("Features");
+    mOffsets.append(0);
+    QPen pen(Qt::black, 1);
+    pen.setCosmetic(true);
+    addStyle(pen, QBrush(Qt::red));
+}
+
+QGVLayerFeatures::~QGVLayerFeatures()
+{
+}
+
+int QGVLayerFeatures::addStyle(const QPen& pen, const QBrush& brush, double pointSize)
+{
+    Q_ASSERT(mStyles.size() <= std::numeric_limits<quint16>::max());
+    Style style{ pen, brush, pointSize };
+    style.pen.setCosmetic(true);
+    mStyles.append(style);
+    return mStyles.size() - 1;
+}
+
+int QGVLayerFeatures::countStyles() const
+{
+    return mStyles.size();
+}
+
+void QGVLayerFeatures::reserve(int features, int points)
+{
+    mTypes.reserve(features);
+    mFlags.reserve(features);
+    mStyleIndex.reserve(features);
+    mOffsets.reserve(features + 1);
+    mGeoPoints.reserve(points);
+    if (mProjection != nullptr) {
+        mProjPoints.reserve(points);
+    }
+}
+
+int QGVLayerFeatures::addPoint(const QGV::GeoPos& geoPos, int style)
+{
+    return addFeature(Point, { geoPos }, style);
+}
+
+int QGVLayerFeatures::addLine(const QList<QGV::GeoPos>& geoPoints, int style)
+{
+    return addFeature(Line, geoPoints, style);
+}
+
+int QGVLayerFeatures::addPolygon(const QList<QGV::GeoPos>& geoPoints, int style)
+{
+    return addFeature(Polygon, geoPoints, style);
+}
+
+void QGVLayerFeatures::clearFeatures()
+{
+    mTypes.clear();
+    mFlags.clear();
+    mStyleIndex.clear();
+    mOffsets.clear();
+    mOffsets.append(0);
+    mGeoPoints.clear();
+    mProjPoints.clear();
+    changed();
+}
+
+int QGVLayerFeatures::countFeatures() const
+{
+    return mTypes.size();
+}
+
+void QGVLayerFeatures::setFeatureStyle(int feature, int style)
+{
+    Q_ASSERT(feature >= 0 && feature < mTypes.size());
+    Q_ASSERT(style >= 0 && style < mStyles.size());
+    if (mStyleIndex.at(feature) == style) {
+        return;
+    }
+    mStyleIndex[feature] = static_cast<quint16>(style);
+    repaint();
+}
+
+int QGVLayerFeatures::getFeatureStyle(int feature) const
+{
+    return mStyleIndex.at(feature);
+}
+
+void QGVLayerFeatures::setFeatureVisible(int feature, bool visible)
+{
+    setFeatureFlag(feature, Hidden, !visible);
+}
+
+bool QGVLayerFeatures::isFeatureVisible(int feature) const
+{
+    return !(mFlags.at(feature) & Hidden);
+}
+
+void QGVLayerFeatures::setFeatureSelected(int feature, bool selected)
+{
+    setFeatureFlag(feature, Selected, selected);
+}
+
+bool QGVLayerFeatures::isFeatureSelected(int feature) const
+{
+    return mFlags.at(feature) & Selected;
+}
+
+QRectF QGVLayerFeatures::featureProjRect(int feature) const
+{
+    const int first = static_cast<int>(mOffsets.at(feature));
+    const int last = static_cast<int>(mOffsets.at(feature + 1));
+    if (mProjPoints.size() < last) {
+        return {};
+    }
+    double left = mProjPoints.at(first).x();
+    double right = left;
+    double top = mProjPoints.at(first).y();
+    double bottom = top;
+    for (int i = first + 1; i < last; i++) {
+        const QPointF& point = mProjPoints.at(i);
+        left = qMin(left, point.x());
+        right = qMax(right, point.x());
+        top = qMin(top, point.y());
+        bottom = qMax(bottom, point.y());
+    }
+    return QRectF(QPointF(left, top), QPointF(right, bottom));
+}
+
+QVector<int> QGVLayerFeatures::searchFeatures(const QRectF& projRect) const
+{
+    QVector<int> features;
+    collectFeatures(projRect, features);
+    std::sort(features.begin(), features.end());
+    return features;
+}
+
+int QGVLayerFeatures::featureAt(const QPointF& projPos, double projTolerance) const
+{
+    QVector<int> features;
+    const QRectF area(projPos.x() - projTolerance, projPos.y() - projTolerance, 2 * projTolerance, 2 * projTolerance);
+    collectFeatures(area, features);
+    // Last added feature is painted on top
+    int result = -1;
+    for (int feature : features) {
+        if (feature > result && isFeatureAt(feature, projPos, projTolerance)) {
+            result = feature;
+        }
+    }
+    return result;
+}
+
+void QGVLayerFeatures::onProjection(QGVMap* geoMap)
+{
+    QGVLayer::onProjection(geoMap);
+    if (!mRenderer.isNull() && mRenderer->scene() != geoMap->geoView()->scene()) {
+        mRenderer.reset(nullptr);
+    }
+    QGraphicsScene* scene = geoMap->geoView()->scene();
+    if (mRenderer.isNull()) {
+        mRenderer.reset(new Renderer(this));
+        scene->addItem(mRenderer.data());
+        // Renderer covers whole scene, so its geometry follows scene rect
+        disconnect(mSceneConnection);
+        mSceneConnection = connect(scene, &QGraphicsScene::sceneRectChanged, this, [this](const QRectF& rect) {
+            if (!mRenderer.isNull()) {
+                mRenderer->setRect(rect);
+            }
+        });
+    }
+    mRenderer->setRect(scene->sceneRect());
+    mProjection = geoMap->getProjection();
+    mProjPoints.clear();
+    projectPoints(0);
+    changed();
+}
+
+void QGVLayerFeatures::onUpdate()
+{
+    QGVLayer::onUpdate();
+    if (mRenderer.isNull()) {
+        return;
+    }
+    mRenderer->setVisible(effectivelyVisible());
+    mRenderer->setOpacity(effectiveOpacity());
+    mRenderer->setZValue(effectiveZValue());
+    mRenderer->update();
+}
+
+void QGVLayerFeatures::onClean()
+{
+    QGVLayer::onClean();
+    disconnect(mSceneConnection);
+    mRenderer.reset(nullptr);
+    mProjection = nullptr;
+    mProjPoints.clear();
+    mGridDirty = true;
+}
+
+int QGVLayerFeatures::addFeature(Type type, const QList<QGV::GeoPos>& geoPoints, int style)
+{
+    Q_ASSERT(style >= 0 && style < mStyles.size());
+    if (geoPoints.isEmpty()) {
+        return -1;
+    }
+    const int first = mGeoPoints.size();
+    for (const QGV::GeoPos& geoPos : geoPoints) {
+        mGeoPoints.append(QPointF(geoPos.longitude(), geoPos.latitude()));
+    }
+    mOffsets.append(static_cast<quint32>(mGeoPoints.size()));
+    mTypes.append(type);
+    mFlags.append(0);
+    mStyleIndex.append(static_cast<quint16>(style));
+    projectPoints(first);
+    changed();
+    return mTypes.size() - 1;
+}
+
+void QGVLayerFeatures::setFeatureFlag(int feature, Flag flag, bool enabled)
+{
+    Q_ASSERT(feature >= 0 && feature < mFlags.size());
+    const quint8 flags = static_cast<quint8>(enabled ? (mFlags.at(feature) | flag) : (mFlags.at(feature) & ~flag));
+    if (mFlags.at(feature) == flags) {
+        return;
+    }
+    mFlags[feature] = flags;
+    repaint();
+}
+
+void QGVLayerFeatures::projectPoints(int first)
+{
+    if (mProjection == nullptr) {
+        return;
+    }
+    mProjPoints.resize(mGeoPoints.size());
+    for (int i = first; i < mGeoPoints.size(); i++) {
+        const QPointF& geoPoint = mGeoPoints.at(i);
+        mProjPoints[i] = mProjection->geoToProj(QGV::GeoPos(geoPoint.y(), geoPoint.x()));
+    }
+}
+
+void QGVLayerFeatures::changed()
+{
+    mGridDirty = true;
+    repaint();
+}
+
+void QGVLayerFeatures::repaint()
+{
+    if (!mRenderer.isNull()) {
+        mRenderer->update();
+    }
+}
+
+void QGVLayerFeatures::buildGrid() const
+{
+    mGridDirty = false;
+    mGridSize = 0;
+    mGridStart.clear();
+    mGridItems.clear();
+    mGridLarge.clear();
+    mGridExtent = QSizeF(0, 0);
+    const int count = mTypes.size();
+    if (count == 0 || mProjPoints.size() != mGeoPoints.size()) {
+        return;
+    }
+
+    double left = mProjPoints.first().x();
+    double right = left;
+    double top = mProjPoints.first().y();
+    double bottom = top;
+    for (const QPointF& point : mProjPoints) {
+        left = qMin(left, point.x());
+        right = qMax(right, point.x());
+        top = qMin(top, point.y());
+        bottom = qMax(bottom, point.y());
+    }
+    mGridRect = QRectF(QPointF(left, top), QPointF(right, bottom));
+    mGridSize = qBound(1, qCeil(qSqrt(count / gridFeaturesPerCell)), maxGridSize);
+    mGridCell = QSizeF((mGridRect.width() > 0) ? mGridRect.width() / mGridSize : 1.0,
+                       (mGridRect.height() > 0) ? mGridRect.height() / mGridSize : 1.0);
+
+    // Feature is kept in cell of its center, queries are expanded by largest half size.
+    // Features larger than few cells are kept aside and checked always.
+    QVector<int> cells(count);
+    mGridStart.fill(0, mGridSize * mGridSize + 1);
+    for (int feature = 0; feature < count; feature++) {
+        const QRectF rect = featureProjRect(feature);
+        if (rect.width() > gridLargeCells * mGridCell.width() || rect.height() > gridLargeCells * mGridCell.height()) {
+            cells[feature] = -1;
+            mGridLarge.append(static_cast<quint32>(feature));
+            continue;
+        }
+        mGridExtent = mGridExtent.expandedTo(rect.size() / 2);
+        const QPointF center = rect.center();
+        const int cellX = qBound(0, static_cast<int>((center.x() - left) / mGridCell.width()), mGridSize - 1);
+        const int cellY = qBound(0, static_cast<int>((center.y() - top) / mGridCell.height()), mGridSize - 1);
+        cells[feature] = cellY * mGridSize + cellX;
+        mGridStart[cells[feature] + 1]++;
+    }
+    for (int i = 1; i < mGridStart.size(); i++) {
+        mGridStart[i] += mGridStart[i - 1];
+    }
+    QVector<quint32> fill = mGridStart;
+    mGridItems.resize(count - mGridLarge.size());
+    for (int feature = 0; feature < count; feature++) {
+        if (cells.at(feature) >= 0) {
+            mGridItems[fill[cells.at(feature)]++] = static_cast<quint32>(feature);
+        }
+    }
+}
+
+void QGVLayerFeatures::collectFeatures(const QRectF& projRect, QVector<int>& features) const
+{
+    if (mGridDirty) {
+        buildGrid();
+    }
+    if (mGridSize == 0) {
+        return;
+    }
+    const QRectF area = projRect.normalized();
+    auto check = [this, &area, &features](int feature) {
+        if (!(mFlags.at(feature) & Hidden) && overlaps(featureProjRect(feature), area)) {
+            features.append(feature);
+        }
+    };
+    const QSizeF extent = mGridExtent;
+    const QRectF cellsArea = area.adjusted(-extent.width(), -extent.height(), extent.width(), extent.height());
+    if (overlaps(cellsArea, mGridRect)) {
+        const auto toCell = [this](double value, double origin, double size) {
+            return qBound(0, static_cast<int>(qFloor((value - origin) / size)), mGridSize - 1);
+        };
+        const int x1 = toCell(cellsArea.left(), mGridRect.left(), mGridCell.width());
+        const int x2 = toCell(cellsArea.right(), mGridRect.left(), mGridCell.width());
+        const int y1 = toCell(cellsArea.top(), mGridRect.top(), mGridCell.height());
+        const int y2 = toCell(cellsArea.bottom(), mGridRect.top(), mGridCell.height());
+        for (int y = y1; y <= y2; y++) {
+            for (int x = x1; x <= x2; x++) {
+                const int cell = y * mGridSize + x;
+                for (quint32 i = mGridStart.at(cell); i < mGridStart.at(cell + 1); i++) {
+                    check(static_cast<int>(mGridItems.at(static_cast<int>(i))));
+                }
+            }
+        }
+    }
+    for (quint32 feature : mGridLarge) {
+        check(static_cast<int>(feature));
+    }
+}
+
+void QGVLayerFeatures::paintFeatures(QPainter* painter, const QRectF& projRect)
+{
+    if (mProjection == nullptr || mTypes.isEmpty()) {
+        return;
+    }
+    const double scale = qSqrt(qAbs(painter->worldTransform().determinant()));
+    if (qFuzzyIsNull(scale)) {
+        return;
+    }
+    double maxPointSize = 0;
+    for (const Style& style : mStyles) {
+        maxPointSize = qMax(maxPointSize, style.pointSize);
+    }
+    const double margin = (maxPointSize + 4) / scale;
+    mPaintFeatures.resize(0);
+    collectFeatures(projRect.adjusted(-margin, -margin, margin, margin), mPaintFeatures);
+
+    // Features are painted in index order, so last added feature is on top as featureAt() expects
+    std::sort(mPaintFeatures.begin(), mPaintFeatures.end());
+
+    if (getMap() != nullptr) {
+        const QColor highlight = getMap()->palette().highlight().color();
+        painter->setBrush(Qt::NoBrush);
+        for (int feature : mPaintFeatures) {
+            if (!(mFlags.at(feature) & Selected)) {
+                continue;
+            }
+            const Style& style = mStyles.at(mStyleIndex.at(feature));
+            const QPointF* points = mProjPoints.constData() + mOffsets.at(feature);
+            const int count = static_cast<int>(mOffsets.at(feature + 1) - mOffsets.at(feature));
+            const double width = (mTypes.at(feature) == Point) ? style.pointSize + 4 : style.pen.widthF() + 4;
+            QPen pen(highlight, width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+            pen.setCosmetic(true);
+            painter->setPen(pen);
+            if (mTypes.at(feature) == Polygon) {
+                painter->drawPolygon(points, count);
+            } else if (mTypes.at(feature) == Line) {
+                painter->drawPolyline(points, count);
+            } else {
+                painter->drawPoint(*points);
+            }
+        }
+    }
+
+    // Consecutive features of same style and kind share painter setup, points of such run are drawn by one call
+    // Shapes smaller than pixel are painted as points
+    enum Kind
+    {
+        NoKind,
+        ShapeKind,
+        TinyKind,
+        PointKind,
+    };
+    Kind runKind = NoKind;
+    int runStyle = -1;
+    mPaintPoints.resize(0);
+    const auto flushPoints = [this, painter]() {
+        if (!mPaintPoints.isEmpty()) {
+            painter->drawPoints(mPaintPoints.constData(), mPaintPoints.size());
+            mPaintPoints.resize(0);
+        }
+    };
+    for (int feature : mPaintFeatures) {
+        const int styleIndex = mStyleIndex.at(feature);
+        const QPointF* points = mProjPoints.constData() + mOffsets.at(feature);
+        Kind kind = PointKind;
+        QRectF rect;
+        if (mTypes.at(feature) != Point) {
+            rect = featureProjRect(feature);
+            kind = (rect.width() * scale < 1 && rect.height() * scale < 1) ? TinyKind : ShapeKind;
+        }
+        if (kind != runKind || styleIndex != runStyle) {
+            flushPoints();
+            runKind = kind;
+            runStyle = styleIndex;
+            const Style& style = mStyles.at(styleIndex);
+            if (kind == PointKind) {
+                const QColor color = (style.brush.style() != Qt::NoBrush) ? style.brush.color() : style.pen.color();
+                QPen pen(color, style.pointSize, Qt::SolidLine, Qt::RoundCap);
+                pen.setCosmetic(true);
+                painter->setPen(pen);
+            } else {
+                painter->setPen(style.pen);
+                painter->setBrush(style.brush);
+            }
+        }
+        if (kind == PointKind) {
+            mPaintPoints.append(*points);
+        } else if (kind == TinyKind) {
+            mPaintPoints.append(rect.center());
+        } else {
+            const int count = static_cast<int>(mOffsets.at(feature + 1) - mOffsets.at(feature));
+            if (mTypes.at(feature) == Polygon) {
+                painter->drawPolygon(points, count);
+            } else {
+                painter->drawPolyline(points, count);
+            }
+        }
+    }
+    flushPoints();
+}
+
+bool QGVLayerFeatures::isFeatureAt(int feature, const QPointF& projPos, double projTolerance) const
+{
+    const int first = static_cast<int>(mOffsets.at(feature));
+    const int last = static_cast<int>(mOffsets.at(feature + 1));
+    if (mTypes.at(feature) == Point) {
+        return segmentDistance(projPos, mProjPoints.at(first), mProjPoints.at(first)) <= projTolerance;
+    }
+    bool inside = false;
+    for (int i = first; i < last; i++) {
+        const QPointF& pt1 = mProjPoints.at(i);
+        const QPointF& pt2 = mProjPoints.at((i + 1 < last) ? i + 1 : first);
+        if (i + 1 < last || mTypes.at(feature) == Polygon) {
+            if (segmentDistance(projPos, pt1, pt2) <= projTolerance) {
+                return true;
+            }
+        }
+        if ((pt1.y() > projPos.y()) != (pt2.y() > projPos.y()) &&
+            projPos.x() < pt1.x() + (projPos.y() - pt1.y()) * (pt2.x() - pt1.x()) / (pt2.y() - pt1.y())) {
+            inside = !inside;
+        }
+    }
+    return mTypes.at(feature) == Polygon && inside;
+}
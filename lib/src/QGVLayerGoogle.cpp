@@ -51,6 +51,7 @@ QGVLayerGoogle::QGVLayerGoogle(QGV::TilesType type, QLocale locale, int serverNu
     , mServerNumber(serverNumber)
 {
     createName();
+    createUrlTemplate();
     setDescription("Copyrights ©Google");
 }
 
@@ -58,12 +59,14 @@ void QGVLayerGoogle::setType(QGV::TilesType type)
 {
     mType = type;
     createName();
+    createUrlTemplate();
 }
 
 void QGVLayerGoogle::setLocale(const QLocale& locale)
 {
     mLocale = locale;
     createName();
+    createUrlTemplate();
 }
 
 QGV::TilesType QGVLayerGoogle::getType() const
@@ -88,6 +91,22 @@ void QGVLayerGoogle::createName()
     setName("Google Maps (" + adapter[mType] + " " + mLocale.name() + ")");
 }
 
+void QGVLayerGoogle::createUrlTemplate()
+{
+    resetTilesId();
+    mUrlTemplates.clear();
+    for (const QString& url : URLTemplates[mType]) {
+        QGVUrlTemplate urlTemplate(url);
+        urlTemplate.setLocale(mLocale.name());
+        mUrlTemplates.append(urlTemplate);
+    }
+}
+
+QString QGVLayerGoogle::getTilesId() const
+{
+    return URLTemplates[mType].first() + "#" + mLocale.name();
+}
+
 int QGVLayerGoogle::minZoomlevel() const
 {
     return 0;
@@ -100,11 +119,5 @@ int QGVLayerGoogle::maxZoomlevel() const
 
 QString QGVLayerGoogle::tilePosToUrl(const QGV::GeoTilePos& tilePos) const
 {
-    const QStringList& list = URLTemplates[mType];
-    QString url = list.value(mServerNumber).toLower();
-    url.replace("${lcl}", mLocale.name());
-    url.replace("${z}", QString::number(tilePos.zoom()));
-    url.replace("${x}", QString::number(tilePos.pos().x()));
-    url.replace("${y}", QString::number(tilePos.pos().y()));
-    return url;
+    return selectServer(tilePos, mUrlTemplates, mServerNumber).expand(tilePos);
 }
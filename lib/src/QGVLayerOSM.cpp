@@ -32,13 +32,21 @@ const QStringList URLTemplates = {
 
 QGVLayerOSM::QGVLayerOSM(int serverNumber)
     : mUrl(URLTemplates.value(serverNumber))
+    , mServerNumber(serverNumber)
+    , mRetinaTiles(false)
 {
+    for (const QString& url : URLTemplates) {
+        mUrlTemplates.append(QGVUrlTemplate(url));
+    }
     setName("OpenStreetMap");
     setDescription("Copyrights ©OpenStreetMap");
 }
 
 QGVLayerOSM::QGVLayerOSM(const QString& url)
     : mUrl(url)
+    , mUrlTemplates({ QGVUrlTemplate(url) })
+    , mServerNumber(0)
+    , mRetinaTiles(false)
 {
     setName("Custom");
     setDescription("OSM-like map");
@@ -47,6 +55,10 @@ QGVLayerOSM::QGVLayerOSM(const QString& url)
 void QGVLayerOSM::setUrl(const QString& url)
 {
     mUrl = url;
+    mUrlTemplates = { QGVUrlTemplate(url) };
+    mUrlTemplates.first().setRetina(mRetinaTiles);
+    mServerNumber = 0;
+    resetTilesId();
 }
 
 QString QGVLayerOSM::getUrl() const
@@ -54,6 +66,32 @@ QString QGVLayerOSM::getUrl() const
     return mUrl;
 }
 
+void QGVLayerOSM::setRetinaTiles(bool enabled)
+{
+    mRetinaTiles = enabled;
+    for (QGVUrlTemplate& urlTemplate : mUrlTemplates) {
+        urlTemplate.setRetina(enabled);
+    }
+    resetTilesId();
+    qgvDebug() << "RetinaTiles changed to" << enabled;
+}
+
+bool QGVLayerOSM::isRetinaTiles() const
+{
+    return mRetinaTiles;
+}
+
+bool QGVLayerOSM::isRetinaUrl() const
+{
+    // @2x tiles are requested only when url has ${r} placeholder
+    return mRetinaTiles && mUrlTemplates.first().hasField(QGVUrlTemplate::Field::Retina);
+}
+
+QString QGVLayerOSM::getTilesId() const
+{
+    return (isRetinaUrl()) ? mUrl + "@2x" : mUrl;
+}
+
 int QGVLayerOSM::minZoomlevel() const
 {
     return 0;
@@ -64,11 +102,13 @@ int QGVLayerOSM::maxZoomlevel() const
     return 20;
 }
 
+double QGVLayerOSM::tilePixelRatio() const
+{
+    // @2x tiles are taken as denser only for HiDPI zoom selection
+    return (isRetinaUrl() && isHiDpiSelection()) ? 2.0 : 1.0;
+}
+
 QString QGVLayerOSM::tilePosToUrl(const QGV::GeoTilePos& tilePos) const
 {
-    QString url = mUrl.toLower();
-    url.replace("${z}", QString::number(tilePos.zoom()));
-    url.replace("${x}", QString::number(tilePos.pos().x()));
-    url.replace("${y}", QString::number(tilePos.pos().y()));
-    return url;
+    return selectServer(tilePos, mUrlTemplates, mServerNumber).expand(tilePos);
 }
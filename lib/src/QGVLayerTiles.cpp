@@ -18,15 +18,146 @@
 
 #include "QGVLayerTiles.h"
 #include "QGVDrawItem.h"
+#include "QGVTileCache.h"
+#include "Raster/QGVImage.h"
 
+#include <QPainter>
 #include <QtMath>
 
+#include <cmath>
+#include <limits>
+
+namespace {
+const qint64 CameraSampleMs = 16;
+const qint64 CameraIdleMs = 300;
+const double VelocitySmoothing = 0.5;
+const qreal PrefetchPenalty = 1e7;
+const int PlanArcTilesLimit = 32;
+
+QPointF unitVector(const QPointF& vector)
+{
+    const double length = qSqrt(QPointF::dotProduct(vector, vector));
+    return (length > 0) ? vector / length : QPointF();
+}
+
+// view polygon is rectangle rotated by azimuth, margin is applied along its own axes
+QPolygonF expandViewPolygon(const QPolygonF& polygon, double distance)
+{
+    if (polygon.size() < 4) {
+        return polygon;
+    }
+    const QPointF u = unitVector(polygon.at(1) - polygon.at(0)) * distance;
+    const QPointF v = unitVector(polygon.at(3) - polygon.at(0)) * distance;
+    QPolygonF result;
+    result << polygon.at(0) - u - v << polygon.at(1) + u - v << polygon.at(2) + u + v << polygon.at(3) - u + v;
+    return result;
+}
+
+// small move of view polygon does not change covered tiles, margin hides the difference
+bool isPolygonMoved(const QPolygonF& from, const QPolygonF& to, double tolerance)
+{
+    if (from.size() != to.size()) {
+        return true;
+    }
+    for (int i = 0; i < from.size(); ++i) {
+        const QPointF delta = to.at(i) - from.at(i);
+        if (qAbs(delta.x()) > tolerance || qAbs(delta.y()) > tolerance) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// separating axis test of convex polygon and axis-aligned rectangle
+bool isConvexIntersects(const QPolygonF& polygon, const QRectF& rect)
+{
+    if (!polygon.boundingRect().intersects(rect)) {
+        return false;
+    }
+    const QPointF corners[] = { rect.topLeft(), rect.topRight(), rect.bottomRight(), rect.bottomLeft() };
+    for (int i = 0; i < polygon.size(); ++i) {
+        const QPointF edge = polygon.at((i + 1) % polygon.size()) - polygon.at(i);
+        const QPointF normal(-edge.y(), edge.x());
+        double polygonMin = std::numeric_limits<double>::max();
+        double polygonMax = std::numeric_limits<double>::lowest();
+        for (const QPointF& point : polygon) {
+            const double projection = QPointF::dotProduct(point, normal);
+            polygonMin = qMin(polygonMin, projection);
+            polygonMax = qMax(polygonMax, projection);
+        }
+        double rectMin = std::numeric_limits<double>::max();
+        double rectMax = std::numeric_limits<double>::lowest();
+        for (const QPointF& point : corners) {
+            const double projection = QPointF::dotProduct(point, normal);
+            rectMin = qMin(rectMin, projection);
+            rectMax = qMax(rectMax, projection);
+        }
+        if (rectMax < polygonMin || rectMin > polygonMax) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+/*
+ * Single scene item which paints all image tiles of layer in zoom order.
+ */
+class QGVLayerTiles::Compositor : public QGVDrawItem
+{
+public:
+    explicit Compositor(const QGVLayerTiles* layer)
+        : mLayer(layer)
+    {
+        setFlag(QGV::ItemFlag::NoCache);
+        setFlag(QGV::ItemFlag::NoSearch);
+    }
+
+    QPainterPath projShape() const override
+    {
+        QPainterPath path;
+        if (getMap() != nullptr) {
+            path.addRect(getMap()->getProjection()->boundaryProjRect());
+        }
+        return path;
+    }
+
+    void projPaint(QPainter* painter) override
+    {
+        mLayer->paintTiles(painter);
+    }
+
+private:
+    const QGVLayerTiles* mLayer;
+};
+
 QGVLayerTiles::QGVLayerTiles()
 {
     mCurZoom = -1;
+    mZoomCandidate = -1;
+    mTick = 0;
+    mUsedBytes = 0;
+    mCameraScale = 0;
+    mZoomVelocity = 0;
+    mZoomDwellTimer.setSingleShot(true);
+    connect(&mZoomDwellTimer, &QTimer::timeout, this, [this]() {
+        processCamera();
+        updatePrefetch();
+    });
     sendToBack();
 }
 
+QGVLayerTiles::~QGVLayerTiles()
+{
+    delete mCompositor;
+    deleteDetachedTiles();
+}
+
+QString QGVLayerTiles::getTilesId() const
+{
+    return metaObject()->className();
+}
+
 void QGVLayerTiles::setTilesMarginWithZoomChange(size_t value)
 {
     mPerfomanceProfile.TilesMarginWithZoomChange = value;
@@ -63,6 +194,68 @@ void QGVLayerTiles::setCameraUpdatesDuringAnimation(bool value)
     qgvDebug() << "CameraUpdatesDuringAnimation changed to" << value;
 }
 
+void QGVLayerTiles::setPrefetchTilesBudget(size_t value)
+{
+    mPerfomanceProfile.PrefetchTilesBudget = value;
+    qgvDebug() << "PrefetchTilesBudget changed to" << value;
+}
+
+void QGVLayerTiles::setPrefetchLookAheadMs(size_t value)
+{
+    mPerfomanceProfile.PrefetchLookAheadMs = value;
+    qgvDebug() << "PrefetchLookAheadMs changed to" << value;
+}
+
+void QGVLayerTiles::setCompositeRendering(bool value)
+{
+    mPerfomanceProfile.CompositeRendering = value;
+    qgvDebug() << "CompositeRendering changed to" << value;
+    updateCompositor();
+}
+
+void QGVLayerTiles::setParentTilesFallback(bool value)
+{
+    mPerfomanceProfile.ParentTilesFallback = value;
+    qgvDebug() << "ParentTilesFallback changed to" << value;
+    updateCompositor();
+}
+
+void QGVLayerTiles::setOverzoomLevels(size_t value)
+{
+    mPerfomanceProfile.OverzoomLevels = value;
+    qgvDebug() << "OverzoomLevels changed to" << value;
+}
+
+void QGVLayerTiles::setHiDpiSelection(bool value)
+{
+    mPerfomanceProfile.HiDpiSelection = value;
+    qgvDebug() << "HiDpiSelection changed to" << value;
+}
+
+void QGVLayerTiles::setMaxTilesBytes(size_t value)
+{
+    mPerfomanceProfile.MaxTilesBytes = value;
+    qgvDebug() << "MaxTilesBytes changed to" << value;
+    removeOverBudget();
+}
+
+qint64 QGVLayerTiles::getUsedBytes() const
+{
+    return mUsedBytes;
+}
+
+void QGVLayerTiles::setZoomHysteresis(double value)
+{
+    mPerfomanceProfile.ZoomHysteresis = value;
+    qgvDebug() << "ZoomHysteresis changed to" << value;
+}
+
+void QGVLayerTiles::setZoomDwellMs(size_t value)
+{
+    mPerfomanceProfile.ZoomDwellMs = value;
+    qgvDebug() << "ZoomDwellMs changed to" << value;
+}
+
 void QGVLayerTiles::onProjection(QGVMap* geoMap)
 {
     QGVLayer::onProjection(geoMap);
@@ -76,11 +269,15 @@ void QGVLayerTiles::onCamera(const QGVCameraState& oldState, const QGVCameraStat
         return;
     }
 
+    trackCamera(newState);
+
     bool needUpdate = true;
 
     if (newState.animation()) {
         if (!mPerfomanceProfile.CameraUpdatesDuringAnimation) {
             needUpdate = false;
+        } else if (!mPlannedTiles.isEmpty()) {
+            needUpdate = isPlannedUpdate(newState);
         } else if (!mLastAnimation.isValid()) {
             mLastAnimation.start();
         } else if (mLastAnimation.elapsed() < static_cast<qint64>(mPerfomanceProfile.AnimationUpdateDelayMs)) {
@@ -94,7 +291,56 @@ void QGVLayerTiles::onCamera(const QGVCameraState& oldState, const QGVCameraStat
 
     if (needUpdate) {
         processCamera();
+        updatePrefetch();
+    }
+}
+
+void QGVLayerTiles::onCameraPlan(const QList<QGVCameraState>& plan)
+{
+    QGVLayer::onCameraPlan(plan);
+
+    mPlannedTiles.clear();
+    mPanVelocity = {};
+    mZoomVelocity = 0;
+    if (getMap() == nullptr || plan.isEmpty()) {
+        // dropped plan also drops its prefetch
+        updatePrefetch();
+        return;
+    }
+
+    // few low zoom tiles covering whole arc
+    int arcZoom = maxZoomlevel();
+    QRectF arcProjRect;
+    for (const QGVCameraState& state : plan) {
+        arcZoom = qMin(arcZoom, qMax(minZoomlevel(), scaleToZoom(state.scale())));
+        arcProjRect = arcProjRect.united(state.projRect());
+    }
+    QRect arcRect = tilesRect(arcZoom, arcProjRect);
+    while (arcZoom > minZoomlevel() && arcRect.width() * arcRect.height() > PlanArcTilesLimit) {
+        arcRect = tilesRect(--arcZoom, arcProjRect);
+    }
+    for (int x = arcRect.left(); x <= arcRect.right(); ++x) {
+        for (int y = arcRect.top(); y <= arcRect.bottom(); ++y) {
+            mPlannedTiles.append(QGV::GeoTilePos(arcZoom, QPoint(x, y)));
+        }
     }
+
+    // destination tiles, center first
+    const QGVCameraState& target = plan.last();
+    const int targetZoom = qMin(maxZoomlevel(), qMax(minZoomlevel(), scaleToZoom(target.scale())));
+    const QRect targetRect = tilesRect(targetZoom, target.projRect());
+    const QPointF targetCenter = QRectF(targetRect).center();
+    QMultiMap<qreal, QGV::GeoTilePos> destination;
+    for (int x = targetRect.left(); x <= targetRect.right(); ++x) {
+        for (int y = targetRect.top(); y <= targetRect.bottom(); ++y) {
+            const qreal radius = qSqrt(qPow(x + 0.5 - targetCenter.x(), 2) + qPow(y + 0.5 - targetCenter.y(), 2));
+            destination.insert(radius, QGV::GeoTilePos(targetZoom, QPoint(x, y)));
+        }
+    }
+    mPlannedTiles.append(destination.values());
+    qgvDebug() << "camera plan with" << mPlannedTiles.size() << "tiles";
+
+    updatePrefetch();
 }
 
 void QGVLayerTiles::onUpdate()
@@ -108,13 +354,35 @@ void QGVLayerTiles::onClean()
     QGVLayer::onClean();
     mCurZoom = -1;
     mCurRect = {};
+    deleteDetachedTiles();
     mIndex.clear();
+    mTileStamps.clear();
+    mUsedBytes = 0;
     deleteItems();
+    updateCompositor();
+    for (const QGV::GeoTilePos& tilePos : mPrefetching) {
+        cancelPrefetch(tilePos);
+    }
+    mPrefetching.clear();
+    mPlannedTiles.clear();
+    for (const QGV::GeoTilePos& sourcePos : mOverzoomSources.keys()) {
+        cancel(sourcePos);
+    }
+    mOverzoomSources.clear();
 }
 
 void QGVLayerTiles::onTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj)
 {
+    if (tilePos.zoom() != mCurZoom && mOverzoomSources.contains(tilePos)) {
+        auto image = qobject_cast<QGVImage*>(tileObj);
+        const bool valid = (image != nullptr && image->isImage());
+        cacheTile(tilePos, tileObj);
+        onOverzoomSource(tilePos, (valid) ? image->getImage() : QImage());
+        delete tileObj;
+        return;
+    }
     if (tilePos.zoom() != mCurZoom || !mCurRect.contains(tilePos.pos())) {
+        cacheTile(tilePos, tileObj);
         delete tileObj;
         return;
     }
@@ -122,24 +390,92 @@ void QGVLayerTiles::onTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj)
 
     removeAllAbove(tilePos);
 
-    const int fromZoom = minZoomlevel();
-    const int toZoom = tilePos.zoom() - 1;
-    for (int zoom = fromZoom; zoom <= toZoom; ++zoom) {
-        for (const QGV::GeoTilePos& below : existingTiles(zoom)) {
-            if (below.contains(tilePos)) {
-                removeWhenCovered(below);
-            }
-        }
+    QGVTileIndex::TileList below;
+    mIndex.ancestors(tilePos, minZoomlevel(), below);
+    for (const QGV::GeoTilePos& target : below) {
+        removeWhenCovered(target);
+    }
+
+    removeOverBudget();
+}
+
+void QGVLayerTiles::onPrefetch(const QGV::GeoTilePos& tilePos, const QImage& image)
+{
+    if (!mPrefetching.remove(tilePos)) {
+        return;
+    }
+    qgvDebug() << "prefetched tile" << tilePos;
+    QGV::getTileCache()->insert(tilesId(), tilePos, image);
+}
+
+void QGVLayerTiles::onTileFailed(const QGV::GeoTilePos& tilePos)
+{
+    if (mOverzoomSources.contains(tilePos)) {
+        onOverzoomSource(tilePos, {});
     }
 }
 
 int QGVLayerTiles::scaleToZoom(double scale) const
 {
-    const double scaleChange = 1 / scale;
-    const int newZoom = qRound((17.0 - qLn(scaleChange) * M_LOG2E));
+    const int newZoom = qRound(fractionalZoom(scale));
     return newZoom;
 }
 
+double QGVLayerTiles::fractionalZoom(double scale) const
+{
+    // tile texels should match device pixels: hidpi screen needs deeper zoom, large tiles need shallower zoom
+    const double scaleChange = 1 / scale;
+    double pixelRatio = 1.0 / tilePixelRatio();
+    if (mPerfomanceProfile.HiDpiSelection && getMap() != nullptr) {
+        pixelRatio *= getMap()->devicePixelRatioF();
+    }
+    return 17.0 - qLn(scaleChange) * M_LOG2E + qLn(pixelRatio) * M_LOG2E;
+}
+
+int QGVLayerTiles::stableZoom(double scale, int zoom)
+{
+    // zoom is changed only when scale is far enough from current level and new level is kept long enough
+    if (mCurZoom < 0 || zoom == mCurZoom) {
+        mZoomDwell.invalidate();
+        return zoom;
+    }
+    const double hysteresis = mPerfomanceProfile.ZoomHysteresis;
+    if (hysteresis > 0 && qAbs(fractionalZoom(scale) - mCurZoom) < 0.5 + hysteresis) {
+        mZoomDwell.invalidate();
+        return mCurZoom;
+    }
+    const qint64 dwellMs = static_cast<qint64>(mPerfomanceProfile.ZoomDwellMs);
+    if (dwellMs > 0) {
+        if (!mZoomDwell.isValid() || mZoomCandidate != zoom) {
+            mZoomDwell.start();
+            mZoomCandidate = zoom;
+        }
+        const qint64 remainingMs = dwellMs - mZoomDwell.elapsed();
+        if (remainingMs > 0) {
+            mZoomDwellTimer.start(static_cast<int>(remainingMs));
+            return mCurZoom;
+        }
+    }
+    mZoomDwell.invalidate();
+    return zoom;
+}
+
+bool QGVLayerTiles::isHiDpiSelection() const
+{
+    return mPerfomanceProfile.HiDpiSelection;
+}
+
+double QGVLayerTiles::tilePixelRatio() const
+{
+    return 1.0;
+}
+
+int QGVLayerTiles::maxOverzoomlevel() const
+{
+    const int overzoom = maxZoomlevel() + static_cast<int>(mPerfomanceProfile.OverzoomLevels);
+    return qMin(overzoom, static_cast<int>(QGVTileIndex::MaxZoom));
+}
+
 void QGVLayerTiles::processCamera()
 {
     if (getMap() == nullptr || !isVisible()) {
@@ -151,10 +487,11 @@ void QGVLayerTiles::processCamera()
     const QGV::GeoRect areaGeoRect = projection->projToGeo(areaProjRect);
 
     int originZoom = scaleToZoom(camera.scale());
-    int newZoom = qMin(maxZoomlevel(), qMax(minZoomlevel(), originZoom));
+    int newZoom = qMin(maxOverzoomlevel(), qMax(minZoomlevel(), originZoom));
     if (newZoom != originZoom) {
         return;
     }
+    newZoom = stableZoom(camera.scale(), newZoom);
 
     const bool zoomChanged = (mCurZoom != newZoom);
     mCurZoom = newZoom;
@@ -165,30 +502,46 @@ void QGVLayerTiles::processCamera()
     const QRect maxRect = QRect(QPoint(0, 0), QPoint(sizePerZoom, sizePerZoom));
     const QPoint topLeft = QGV::GeoTilePos::geoToTilePos(mCurZoom, areaGeoRect.topLeft()).pos();
     const QPoint bottomRight = QGV::GeoTilePos::geoToTilePos(mCurZoom, areaGeoRect.bottomRight()).pos();
+    mVisibleRect = QRect(topLeft, bottomRight).intersected(maxRect);
     QRect activeRect = QRect(topLeft, bottomRight);
     activeRect = activeRect.adjusted(-margin, -margin, margin, margin);
     activeRect = activeRect.intersected(maxRect);
     const bool rectChanged = (!zoomChanged && (mCurRect != activeRect));
     mCurRect = activeRect;
 
-    if (!zoomChanged && !rectChanged) {
+    // rotated view covers only part of its bounding rect, so tiles are also checked against exact view polygon
+    const bool rotated = !qFuzzyIsNull(std::remainder(camera.azimuth(), 90.0));
+    const double tileProjSize = projection->boundaryProjRect().width() / sizePerZoom;
+    const QPolygonF activeArea = (rotated) ? expandViewPolygon(camera.projPolygon(), margin * tileProjSize)
+                                           : QPolygonF();
+    const bool areaChanged = (!zoomChanged && isPolygonMoved(mActiveArea, activeArea, tileProjSize / 4));
+
+    if (!zoomChanged && !rectChanged && !areaChanged) {
         return;
     }
+    mActiveArea = activeArea;
+    mKeepArea = (rotated) ? expandViewPolygon(camera.projPolygon(), (margin + 1) * tileProjSize) : QPolygonF();
 
     if (zoomChanged) {
         qgvDebug() << "new active zoom" << mCurZoom;
         const int fromZoom = minZoomlevel();
-        const int toZoom = maxZoomlevel();
+        const int toZoom = maxOverzoomlevel();
+        QGVTileIndex::TileList existing;
         for (int zoom = fromZoom; zoom <= toZoom; ++zoom) {
+            mIndex.tiles(zoom, existing);
             if (zoom == mCurZoom) {
-                for (const QGV::GeoTilePos& current : existingTiles(zoom)) {
+                for (const QGV::GeoTilePos& current : existing) {
                     removeAllAbove(current);
                 }
             } else {
-                for (const QGV::GeoTilePos& nonCurrent : existingTiles(zoom)) {
+                for (const QGV::GeoTilePos& nonCurrent : existing) {
                     if (!isTileFinished(nonCurrent)) {
                         qgvDebug() << "cancel non-finished" << nonCurrent;
                         removeTile(nonCurrent);
+                    } else if (zoom < mCurZoom && mPerfomanceProfile.ParentTilesFallback) {
+                        qgvDebug() << "keep as fallback image only" << nonCurrent;
+                        removeTile(nonCurrent);
+                        continue;
                     } else if (zoom < mCurZoom) {
                         removeWhenCovered(nonCurrent);
                     }
@@ -198,57 +551,340 @@ void QGVLayerTiles::processCamera()
         }
     }
 
-    if (rectChanged) {
+    if (rectChanged || areaChanged) {
         qgvDebug() << "new active rect" << mCurRect.topLeft() << mCurRect.bottomRight();
-        for (const QGV::GeoTilePos& tilePos : existingTiles(mCurZoom)) {
-            if (!mCurRect.contains(tilePos.pos())) {
+        QGVTileIndex::TileList existing;
+        mIndex.tiles(mCurZoom, existing);
+        for (const QGV::GeoTilePos& tilePos : existing) {
+            if (!mCurRect.contains(tilePos.pos()) || !isTileInArea(tilePos, mKeepArea)) {
                 qgvDebug() << "delete out of boundary view" << tilePos;
                 removeTile(tilePos);
             }
         }
     }
 
+    mTick++;
     QMultiMap<qreal, QGV::GeoTilePos> missing;
     for (int x = mCurRect.left(); x < mCurRect.right(); ++x) {
         for (int y = mCurRect.top(); y < mCurRect.bottom(); ++y) {
             const auto tilePos = QGV::GeoTilePos(mCurZoom, QPoint(x, y));
             if (isTileExists(tilePos)) {
+                if (mVisibleRect.contains(tilePos.pos())) {
+                    mTileStamps[tilePos] = mTick;
+                }
                 continue;
             }
-            qreal radius = qSqrt(qPow(x - mCurRect.center().x(), 2) + qPow(y - mCurRect.center().y(), 2));
-            missing.insert(radius, tilePos);
+            if (!isTileInArea(tilePos, mActiveArea)) {
+                continue;
+            }
+            missing.insert(tilePriority(tilePos), tilePos);
         }
     }
 
     for (const QGV::GeoTilePos& tilePos : missing) {
         addTile(tilePos, nullptr);
     }
+    removeOverBudget();
+
+    reprioritize();
 }
 
-void QGVLayerTiles::removeAllAbove(const QGV::GeoTilePos& tilePos)
+void QGVLayerTiles::reprioritize()
+{
+}
+
+bool QGVLayerTiles::prefetch(const QGV::GeoTilePos& tilePos)
+{
+    Q_UNUSED(tilePos);
+    return false;
+}
+
+void QGVLayerTiles::cancelPrefetch(const QGV::GeoTilePos& tilePos)
+{
+    Q_UNUSED(tilePos);
+}
+
+bool QGVLayerTiles::isPlannedUpdate(const QGVCameraState& state) const
+{
+    // along planned path tiles are changed only when zoom changed or view left active area
+    const int zoom = qMin(maxOverzoomlevel(), qMax(minZoomlevel(), scaleToZoom(state.scale())));
+    if (zoom != mCurZoom) {
+        return true;
+    }
+    return !mCurRect.contains(tilesRect(mCurZoom, state.projRect()));
+}
+
+QString QGVLayerTiles::tilesId() const
+{
+    // id is used in every cache lookup, so it is built once per tile source
+    if (mCachedTilesId.isEmpty()) {
+        mCachedTilesId = getTilesId();
+    }
+    return mCachedTilesId;
+}
+
+void QGVLayerTiles::resetTilesId()
+{
+    mCachedTilesId.clear();
+}
+
+qreal QGVLayerTiles::tilePriority(const QGV::GeoTilePos& tilePos) const
 {
-    const int fromZoom = tilePos.zoom() + 1;
-    const int toZoom = maxZoomlevel();
-    for (int zoom = fromZoom; zoom <= toZoom; ++zoom) {
-        for (const QGV::GeoTilePos& target : existingTiles(zoom)) {
-            if (!tilePos.contains(target)) {
+    // prefetch after everything, then current zoom first, then visible before margin, then center before edge
+    const qreal prefetchPenalty = (mPrefetching.contains(tilePos)) ? PrefetchPenalty : 0;
+    const qreal zoomPenalty = 1e6 * qAbs(tilePos.zoom() - mCurZoom);
+    const bool isVisible = (tilePos.zoom() == mCurZoom) && mVisibleRect.contains(tilePos.pos());
+    const qreal marginPenalty = (isVisible) ? 0 : 1e5;
+    const qreal scale = qPow(2, mCurZoom - tilePos.zoom());
+    const QPointF tileCenter = (QPointF(tilePos.pos()) + QPointF(0.5, 0.5)) * scale;
+    const QPointF viewCenter = QRectF(mVisibleRect).center();
+    const qreal radius = qSqrt(qPow(tileCenter.x() - viewCenter.x(), 2) + qPow(tileCenter.y() - viewCenter.y(), 2));
+    return prefetchPenalty + zoomPenalty + marginPenalty + radius;
+}
+
+void QGVLayerTiles::trackCamera(const QGVCameraState& state)
+{
+    if (!mCameraClock.isValid() || mCameraClock.elapsed() > CameraIdleMs) {
+        mCameraClock.start();
+        mCameraCenter = state.projCenter();
+        mCameraScale = state.scale();
+        mPanVelocity = {};
+        mZoomVelocity = 0;
+        return;
+    }
+    const qint64 elapsed = mCameraClock.elapsed();
+    if (elapsed < CameraSampleMs) {
+        return;
+    }
+    const QPointF panVelocity = (state.projCenter() - mCameraCenter) / static_cast<double>(elapsed);
+    const double zoomVelocity = qLn(state.scale() / mCameraScale) * M_LOG2E / static_cast<double>(elapsed);
+    mPanVelocity = mPanVelocity * (1 - VelocitySmoothing) + panVelocity * VelocitySmoothing;
+    mZoomVelocity = mZoomVelocity * (1 - VelocitySmoothing) + zoomVelocity * VelocitySmoothing;
+    mCameraClock.restart();
+    mCameraCenter = state.projCenter();
+    mCameraScale = state.scale();
+}
+
+void QGVLayerTiles::updatePrefetch()
+{
+    QList<QGV::GeoTilePos> wanted;
+    for (const QGV::GeoTilePos& tilePos : mPlannedTiles) {
+        if (isPrefetchNeeded(tilePos)) {
+            wanted.append(tilePos);
+        }
+    }
+    const int budget = static_cast<int>(mPerfomanceProfile.PrefetchTilesBudget);
+    if (getMap() != nullptr && isVisible() && mCurZoom >= 0 && budget > 0 && mPlannedTiles.isEmpty()) {
+        const QGVCameraState camera = getMap()->getCamera();
+        const double lookAhead = static_cast<double>(mPerfomanceProfile.PrefetchLookAheadMs);
+        const QRectF predictedRect = camera.projRect().translated(mPanVelocity * lookAhead);
+        const double predictedScale = camera.scale() * qPow(2, mZoomVelocity * lookAhead);
+        const int predictedZoom = qMin(maxZoomlevel(), qMax(minZoomlevel(), scaleToZoom(predictedScale)));
+
+        QMultiMap<qreal, QGV::GeoTilePos> candidates;
+        if (!mPanVelocity.isNull()) {
+            prefetchCandidates(mCurZoom, predictedRect, candidates);
+        }
+        if (predictedZoom != mCurZoom) {
+            prefetchCandidates(predictedZoom, predictedRect, candidates);
+        }
+        for (const QGV::GeoTilePos& tilePos : candidates) {
+            if (wanted.size() >= budget) {
+                break;
+            }
+            wanted.append(tilePos);
+        }
+    }
+
+    for (const QGV::GeoTilePos& tilePos : mPrefetching.values()) {
+        if (!wanted.contains(tilePos)) {
+            qgvDebug() << "cancel prefetch" << tilePos;
+            mPrefetching.remove(tilePos);
+            cancelPrefetch(tilePos);
+        }
+    }
+    for (const QGV::GeoTilePos& tilePos : wanted) {
+        if (mPrefetching.contains(tilePos)) {
+            continue;
+        }
+        mPrefetching.insert(tilePos);
+        if (!prefetch(tilePos)) {
+            mPrefetching.remove(tilePos);
+        }
+    }
+}
+
+void QGVLayerTiles::prefetchCandidates(int zoom,
+                                       const QRectF& projRect,
+                                       QMultiMap<qreal, QGV::GeoTilePos>& result) const
+{
+    // overzoom tiles are made from max zoom tiles, so only them can be prefetched
+    zoom = qMin(zoom, maxZoomlevel());
+    const QRect rect = tilesRect(zoom, projRect);
+    if (rect.isEmpty()) {
+        return;
+    }
+    const QPointF center = QRectF(rect).center();
+    for (int x = rect.left(); x <= rect.right(); ++x) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            if (zoom == mCurZoom && mCurRect.contains(QPoint(x, y))) {
                 continue;
             }
-            qgvDebug() << "remove" << target << "above" << tilePos;
-            removeTile(target);
+            const auto tilePos = QGV::GeoTilePos(zoom, QPoint(x, y));
+            if (!isPrefetchNeeded(tilePos)) {
+                continue;
+            }
+            const qreal radius = qSqrt(qPow(x + 0.5 - center.x(), 2) + qPow(y + 0.5 - center.y(), 2));
+            result.insert(radius, tilePos);
         }
     }
 }
 
+bool QGVLayerTiles::isPrefetchNeeded(const QGV::GeoTilePos& tilePos) const
+{
+    return !mIndex.contains(tilePos) && !QGV::getTileCache()->contains(tilesId(), tilePos);
+}
+
+bool QGVLayerTiles::isComposited(QGVDrawItem* tileObj) const
+{
+    const bool enabled = mPerfomanceProfile.CompositeRendering || mPerfomanceProfile.ParentTilesFallback;
+    return enabled && qobject_cast<QGVImage*>(tileObj) != nullptr;
+}
+
+void QGVLayerTiles::updateCompositor()
+{
+    const bool enabled = mPerfomanceProfile.CompositeRendering || mPerfomanceProfile.ParentTilesFallback;
+    if (mCompositor != nullptr && mCompositor->getParent() != this) {
+        // compositor was taken away with other children, it is not owned by layer anymore
+        mCompositor = nullptr;
+    }
+    if (enabled && mCompositor == nullptr) {
+        mCompositor = new Compositor(this);
+        addItem(mCompositor);
+    } else if (!enabled && mCompositor != nullptr) {
+        delete mCompositor;
+    }
+    mIndex.forEach([this](const QGV::GeoTilePos& /*tilePos*/, QGVDrawItem* tile) {
+        if (qobject_cast<QGVImage*>(tile) == nullptr) {
+            return;
+        }
+        if (isComposited(tile)) {
+            removeItem(tile);
+        } else {
+            addItem(tile);
+        }
+    });
+    if (mCompositor != nullptr) {
+        mCompositor->repaint();
+    }
+}
+
+void QGVLayerTiles::paintTiles(QPainter* painter) const
+{
+    if (getMap() == nullptr) {
+        return;
+    }
+    const QGVProjection* projection = getMap()->getProjection();
+    const QGVCameraState camera = getMap()->getCamera();
+    const QRectF viewRect = camera.projRect();
+    const double pixelFactor = 1.0 / camera.scale();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+
+    if (mPerfomanceProfile.ParentTilesFallback && mCurZoom >= 0) {
+        const QRect rect = tilesRect(mCurZoom, viewRect);
+        for (int x = rect.left(); x <= rect.right(); ++x) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                const auto tilePos = QGV::GeoTilePos(mCurZoom, QPoint(x, y));
+                if (isTileFinished(tilePos)) {
+                    continue;
+                }
+                QRectF paintRect = projection->geoToProj(tilePos.toGeoRect());
+                paintRect.setSize(paintRect.size() + QSizeF(pixelFactor, pixelFactor));
+                paintFallback(painter, tilePos, paintRect);
+            }
+        }
+    }
+
+    mIndex.forEach([&](const QGV::GeoTilePos& tilePos, QGVDrawItem* tile) {
+        auto image = qobject_cast<QGVImage*>(tile);
+        if (image == nullptr || image->getParent() != nullptr || !image->isImage()) {
+            return;
+        }
+        QRectF paintRect = projection->geoToProj(tilePos.toGeoRect());
+        if (!paintRect.intersects(viewRect)) {
+            return;
+        }
+        paintRect.setSize(paintRect.size() + QSizeF(pixelFactor, pixelFactor));
+        painter->drawImage(paintRect, image->getImage());
+    });
+}
+
+void QGVLayerTiles::paintFallback(QPainter* painter, const QGV::GeoTilePos& tilePos, const QRectF& paintRect) const
+{
+    const QString layerId = tilesId();
+    for (int zoom = tilePos.zoom() - 1; zoom >= minZoomlevel(); --zoom) {
+        const QGV::GeoTilePos parentPos = tilePos.parent(zoom);
+        QImage image;
+        auto parentTile = qobject_cast<QGVImage*>(mIndex.value(parentPos));
+        if (parentTile != nullptr) {
+            image = parentTile->getImage();
+        } else {
+            image = QGV::getTileCache()->peek(layerId, parentPos);
+        }
+        if (image.isNull()) {
+            continue;
+        }
+        const int parts = 1 << (tilePos.zoom() - zoom);
+        const QSizeF partSize = QSizeF(image.size()) / parts;
+        const QPointF partPos((tilePos.pos().x() % parts) * partSize.width(),
+                              (tilePos.pos().y() % parts) * partSize.height());
+        painter->drawImage(paintRect, image, QRectF(partPos, partSize));
+        return;
+    }
+}
+
+void QGVLayerTiles::deleteDetachedTiles()
+{
+    mIndex.forEach([](const QGV::GeoTilePos& /*tilePos*/, QGVDrawItem* tile) {
+        if (tile != nullptr && tile->getParent() == nullptr) {
+            delete tile;
+        }
+    });
+}
+
+QRect QGVLayerTiles::tilesRect(int zoom, const QRectF& projRect) const
+{
+    const QGVProjection* projection = getMap()->getProjection();
+    const QRectF areaProjRect = projRect.intersected(projection->boundaryProjRect());
+    if (areaProjRect.isEmpty()) {
+        return {};
+    }
+    const QGV::GeoRect areaGeoRect = projection->projToGeo(areaProjRect);
+    const int sizePerZoom = static_cast<int>(qPow(2, zoom));
+    const QRect maxRect = QRect(QPoint(0, 0), QPoint(sizePerZoom - 1, sizePerZoom - 1));
+    const QPoint topLeft = QGV::GeoTilePos::geoToTilePos(zoom, areaGeoRect.topLeft()).pos();
+    const QPoint bottomRight = QGV::GeoTilePos::geoToTilePos(zoom, areaGeoRect.bottomRight()).pos();
+    return QRect(topLeft, bottomRight).intersected(maxRect);
+}
+
+void QGVLayerTiles::removeAllAbove(const QGV::GeoTilePos& tilePos)
+{
+    QGVTileIndex::TileList above;
+    mIndex.descendants(tilePos, tilePos.zoom() + 1, maxOverzoomlevel(), above);
+    for (const QGV::GeoTilePos& target : above) {
+        qgvDebug() << "remove" << target << "above" << tilePos;
+        removeTile(target);
+    }
+}
+
 void QGVLayerTiles::removeWhenCovered(const QGV::GeoTilePos& tilePos)
 {
     const int zoomDelta = mCurZoom - tilePos.zoom() + 1;
     const int neededCount = static_cast<int>(qPow(2, zoomDelta));
     int count = neededCount;
-    for (const QGV::GeoTilePos& current : existingTiles(mCurZoom)) {
-        if (!tilePos.contains(current)) {
-            continue;
-        }
+    QGVTileIndex::TileList covering;
+    mIndex.descendants(tilePos, mCurZoom, mCurZoom, covering);
+    for (const QGV::GeoTilePos& current : covering) {
         if (!isTileFinished(current)) {
             break;
         }
@@ -267,6 +903,9 @@ void QGVLayerTiles::removeWhenCovered(const QGV::GeoTilePos& tilePos)
 
 void QGVLayerTiles::removeForPerfomance(const QGV::GeoTilePos& tilePos)
 {
+    if (mPerfomanceProfile.MaxTilesBytes > 0) {
+        return;
+    }
     const auto minZoom = mCurZoom - static_cast<int>(mPerfomanceProfile.VisibleZoomLayersBelowCurrent);
     const auto maxZoom = mCurZoom + static_cast<int>(mPerfomanceProfile.VisibleZoomLayersAboveCurrent);
 
@@ -276,6 +915,51 @@ void QGVLayerTiles::removeForPerfomance(const QGV::GeoTilePos& tilePos)
     }
 }
 
+void QGVLayerTiles::removeOverBudget()
+{
+    const qint64 maxBytes = static_cast<qint64>(mPerfomanceProfile.MaxTilesBytes);
+    if (maxBytes <= 0 || mUsedBytes <= maxBytes) {
+        return;
+    }
+    // tiles of request area would be requested again by next camera update, so they are never evicted
+    QMultiMap<qreal, QGV::GeoTilePos> candidates;
+    mIndex.forEach([&](const QGV::GeoTilePos& tilePos, QGVDrawItem* tile) {
+        const bool requested = (tilePos.zoom() == mCurZoom && mCurRect.contains(tilePos.pos()) &&
+                                isTileInArea(tilePos, mActiveArea));
+        if (tile == nullptr || requested) {
+            return;
+        }
+        candidates.insert(retentionScore(tilePos), tilePos);
+    });
+    for (const QGV::GeoTilePos& tilePos : candidates) {
+        if (mUsedBytes <= maxBytes) {
+            break;
+        }
+        qgvDebug() << "delete because of memory budget" << tilePos << mUsedBytes << maxBytes;
+        removeTile(tilePos);
+    }
+}
+
+qreal QGVLayerTiles::retentionScore(const QGV::GeoTilePos& tilePos) const
+{
+    // visible tiles are kept always, then tiles of current zoom in margin, then by zoom distance and last use
+    const bool inMargin = (tilePos.zoom() == mCurZoom && mCurRect.contains(tilePos.pos()));
+    const qreal marginPenalty = (inMargin) ? 0 : 1e6;
+    const qreal zoomPenalty = 1e3 * qAbs(tilePos.zoom() - mCurZoom);
+    const qreal age = static_cast<qreal>(mTick - mTileStamps.value(tilePos, 0));
+    return -(marginPenalty + zoomPenalty + age);
+}
+
+qint64 QGVLayerTiles::tileBytes(QGVDrawItem* tileObj)
+{
+    auto image = qobject_cast<QGVImage*>(tileObj);
+    if (image == nullptr || !image->isImage()) {
+        return 0;
+    }
+    const QImage tileImage = image->getImage();
+    return static_cast<qint64>(tileImage.bytesPerLine()) * tileImage.height();
+}
+
 void QGVLayerTiles::addTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj)
 {
     if (isTileFinished(tilePos)) {
@@ -284,42 +968,176 @@ void QGVLayerTiles::addTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj
     }
     if (tileObj == nullptr) {
         qgvDebug() << "request tile" << tilePos;
-        mIndex[tilePos.zoom()][tilePos] = nullptr;
-        request(tilePos);
+        mIndex.insert(tilePos, nullptr);
+        mPrefetching.remove(tilePos);
+        QGVDrawItem* cached = restoreTile(tilePos);
+        if (cached != nullptr) {
+            onTile(tilePos, cached);
+        } else if (tilePos.zoom() > maxZoomlevel()) {
+            requestOverzoom(tilePos);
+        } else {
+            request(tilePos);
+        }
     } else {
         qgvDebug() << "add tile" << tilePos;
-        mIndex[tilePos.zoom()][tilePos] = tileObj;
+        mIndex.insert(tilePos, tileObj);
+        mTileStamps[tilePos] = mTick;
+        mUsedBytes += tileBytes(tileObj);
         tileObj->setZValue(static_cast<qint16>(tilePos.zoom()));
-        addItem(tileObj);
+        if (!isComposited(tileObj)) {
+            addItem(tileObj);
+        } else if (mCompositor != nullptr) {
+            mCompositor->repaint();
+        }
     }
 }
 
 void QGVLayerTiles::removeTile(const QGV::GeoTilePos& tilePos)
 {
-    const auto tile = mIndex[tilePos.zoom()].take(tilePos);
+    const auto tile = mIndex.take(tilePos);
     if (tile == nullptr) {
         qgvDebug() << "cancel tile" << tilePos;
-        cancel(tilePos);
+        if (tilePos.zoom() > maxZoomlevel()) {
+            cancelOverzoom(tilePos);
+        } else {
+            cancel(tilePos);
+        }
     } else {
         qgvDebug() << "remove tile" << tilePos;
+        mTileStamps.remove(tilePos);
+        mUsedBytes -= tileBytes(tile);
+        cacheTile(tilePos, tile);
+        const bool detached = (tile->getParent() == nullptr);
         delete tile;
+        if (detached && mCompositor != nullptr) {
+            mCompositor->repaint();
+        }
     }
 }
 
+void QGVLayerTiles::cacheTile(const QGV::GeoTilePos& tilePos, QGVDrawItem* tileObj) const
+{
+    auto image = qobject_cast<QGVImage*>(tileObj);
+    if (image == nullptr || !image->isImage()) {
+        return;
+    }
+    QGV::getTileCache()->insert(tilesId(), tilePos, image->getImage());
+}
+
+QGVDrawItem* QGVLayerTiles::restoreTile(const QGV::GeoTilePos& tilePos) const
+{
+    const QImage image = QGV::getTileCache()->find(tilesId(), tilePos);
+    if (image.isNull()) {
+        return nullptr;
+    }
+    qgvDebug() << "restore from cache" << tilePos;
+    return createImageTile(tilePos, image, "cache");
+}
+
+QGVImage* QGVLayerTiles::createImageTile(const QGV::GeoTilePos& tilePos,
+                                         const QImage& image,
+                                         const QString& source) const
+{
+    auto tile = new QGVImage();
+    tile->setGeometry(tilePos.toGeoRect());
+    tile->loadImage(image);
+    tile->setProperty("drawDebug",
+                      QString("%1\ntile(%2,%3,%4)")
+                              .arg(source)
+                              .arg(tilePos.zoom())
+                              .arg(tilePos.pos().x())
+                              .arg(tilePos.pos().y()));
+    return tile;
+}
+
 bool QGVLayerTiles::isTileExists(const QGV::GeoTilePos& tilePos) const
 {
-    return mIndex[tilePos.zoom()].contains(tilePos);
+    return mIndex.contains(tilePos);
 }
 
 bool QGVLayerTiles::isTileFinished(const QGV::GeoTilePos& tilePos) const
 {
-    if (!isTileExists(tilePos)) {
-        return false;
+    return mIndex.value(tilePos) != nullptr;
+}
+
+bool QGVLayerTiles::isTileInArea(const QGV::GeoTilePos& tilePos, const QPolygonF& area) const
+{
+    if (area.isEmpty()) {
+        return true;
+    }
+    return isConvexIntersects(area, getMap()->getProjection()->geoToProj(tilePos.toGeoRect()));
+}
+
+QImage QGVLayerTiles::sourceImage(const QGV::GeoTilePos& tilePos) const
+{
+    auto tile = qobject_cast<QGVImage*>(mIndex.value(tilePos));
+    if (tile != nullptr) {
+        return tile->getImage();
+    }
+    return QGV::getTileCache()->peek(tilesId(), tilePos);
+}
+
+void QGVLayerTiles::requestOverzoom(const QGV::GeoTilePos& tilePos)
+{
+    const QGV::GeoTilePos sourcePos = tilePos.parent(maxZoomlevel());
+    const QImage image = sourceImage(sourcePos);
+    if (!image.isNull()) {
+        onTile(tilePos, createOverzoomTile(tilePos, sourcePos, image));
+        return;
+    }
+    const bool started = mOverzoomSources.contains(sourcePos);
+    mOverzoomSources[sourcePos].insert(tilePos);
+    if (!started) {
+        // source is loaded as usual tile and taken from onTile() or onTileFailed()
+        qgvDebug() << "request overzoom source" << sourcePos;
+        mPrefetching.remove(sourcePos);
+        request(sourcePos);
+    }
+}
+
+void QGVLayerTiles::cancelOverzoom(const QGV::GeoTilePos& tilePos)
+{
+    const QGV::GeoTilePos sourcePos = tilePos.parent(maxZoomlevel());
+    auto it = mOverzoomSources.find(sourcePos);
+    if (it == mOverzoomSources.end()) {
+        return;
+    }
+    it->remove(tilePos);
+    if (!it->isEmpty()) {
+        return;
+    }
+    mOverzoomSources.erase(it);
+    cancel(sourcePos);
+}
+
+void QGVLayerTiles::onOverzoomSource(const QGV::GeoTilePos& sourcePos, const QImage& image)
+{
+    const QSet<QGV::GeoTilePos> waiting = mOverzoomSources.take(sourcePos);
+    if (image.isNull()) {
+        // failed tiles are forgotten, so they are requested again when view is changed
+        for (const QGV::GeoTilePos& tilePos : waiting) {
+            qgvDebug() << "no overzoom source for" << tilePos;
+            if (mIndex.contains(tilePos) && mIndex.value(tilePos) == nullptr) {
+                mIndex.take(tilePos);
+            }
+        }
+        return;
+    }
+    for (const QGV::GeoTilePos& tilePos : waiting) {
+        onTile(tilePos, createOverzoomTile(tilePos, sourcePos, image));
     }
-    return mIndex[tilePos.zoom()][tilePos] != nullptr;
 }
 
-QList<QGV::GeoTilePos> QGVLayerTiles::existingTiles(int zoom) const
+QGVImage* QGVLayerTiles::createOverzoomTile(const QGV::GeoTilePos& tilePos,
+                                            const QGV::GeoTilePos& sourcePos,
+                                            const QImage& image) const
 {
-    return mIndex[zoom].keys();
+    // crop part of source tile and upscale it once to tile resolution
+    const int parts = 1 << (tilePos.zoom() - sourcePos.zoom());
+    const QPoint part(tilePos.pos().x() % parts, tilePos.pos().y() % parts);
+    const QPoint topLeft(part.x() * image.width() / parts, part.y() * image.height() / parts);
+    const QPoint bottomRight((part.x() + 1) * image.width() / parts, (part.y() + 1) * image.height() / parts);
+    const QImage cropped = image.copy(QRect(topLeft, bottomRight - QPoint(1, 1)));
+    const QImage scaled = cropped.scaled(image.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    return createImageTile(tilePos, scaled, "overzoom");
 }
@@ -0,0 +1,151 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVLayerTilesLocal.h"
+#include "QGVTileDecoder.h"
+#include "QGVTileStore.h"
+
+#include <QDir>
+
+QGVLayerTilesLocal::QGVLayerTilesLocal(const QString& dirPath, const QString& filePattern, int minZoom, int maxZoom)
+    : mDirPath(dirPath)
+    , mFileTemplate(filePattern)
+    , mTilesId(QDir(dirPath).absoluteFilePath(filePattern))
+    , mMinZoom(minZoom)
+    , mMaxZoom(maxZoom)
+{
+    setName("Local");
+    setDescription(mTilesId);
+}
+
+QGVLayerTilesLocal::QGVLayerTilesLocal(QGVTileStore* store, const QString& tilesId, int minZoom, int maxZoom)
+    : mStore(store)
+    , mTilesId(tilesId)
+    , mMinZoom(minZoom)
+    , mMaxZoom(maxZoom)
+{
+    setName("Local");
+    setDescription(tilesId);
+    if (store != nullptr && !store->isReadOnly()) {
+        qgvWarning() << "local tiles are read from writable tile store" << store->getFilePath();
+    }
+}
+
+QGVLayerTilesLocal::~QGVLayerTilesLocal()
+{
+    for (quint64 ticket : mDecoding) {
+        QGV::getTileDecoder()->cancel(ticket);
+    }
+}
+
+QString QGVLayerTilesLocal::getTilesId() const
+{
+    return mTilesId;
+}
+
+QString QGVLayerTilesLocal::tilePosToFilePath(const QGV::GeoTilePos& tilePos) const
+{
+    return QDir(mDirPath).filePath(mFileTemplate.expand(tilePos));
+}
+
+int QGVLayerTilesLocal::minZoomlevel() const
+{
+    return mMinZoom;
+}
+
+int QGVLayerTilesLocal::maxZoomlevel() const
+{
+    return mMaxZoom;
+}
+
+void QGVLayerTilesLocal::request(const QGV::GeoTilePos& tilePos)
+{
+    if (mPrefetch.remove(tilePos)) {
+        qgvDebug() << "promote prefetch" << tilePos;
+        return;
+    }
+    decodeTile(tilePos);
+}
+
+void QGVLayerTilesLocal::cancel(const QGV::GeoTilePos& tilePos)
+{
+    mPrefetch.remove(tilePos);
+    removeDecoding(tilePos);
+}
+
+bool QGVLayerTilesLocal::prefetch(const QGV::GeoTilePos& tilePos)
+{
+    if (mDecoding.contains(tilePos)) {
+        return false;
+    }
+    mPrefetch.insert(tilePos);
+    decodeTile(tilePos);
+    return true;
+}
+
+void QGVLayerTilesLocal::cancelPrefetch(const QGV::GeoTilePos& tilePos)
+{
+    if (!mPrefetch.contains(tilePos)) {
+        return;
+    }
+    cancel(tilePos);
+}
+
+void QGVLayerTilesLocal::decodeTile(const QGV::GeoTilePos& tilePos)
+{
+    QGVTileDecoder* decoder = QGV::getTileDecoder();
+    if (mStore.isNull()) {
+        const QString filePath = tilePosToFilePath(tilePos);
+        mDecoding[tilePos] = decoder->decodeFile(filePath, [this, tilePos, filePath](const QImage& image) {
+            onTileDecoded(tilePos, image, filePath);
+        });
+        return;
+    }
+    const QByteArray rawImage = mStore->load(mTilesId, tilePos);
+    if (rawImage.isEmpty()) {
+        onTileDecoded(tilePos, {}, {});
+        return;
+    }
+    const QString source = mStore->getFilePath();
+    mDecoding[tilePos] = decoder->decode(rawImage, [this, tilePos, source](const QImage& image) {
+        onTileDecoded(tilePos, image, source);
+    });
+}
+
+void QGVLayerTilesLocal::onTileDecoded(const QGV::GeoTilePos& tilePos, const QImage& image, const QString& source)
+{
+    mDecoding.remove(tilePos);
+    if (mPrefetch.remove(tilePos)) {
+        onPrefetch(tilePos, image);
+        return;
+    }
+    if (image.isNull()) {
+        qgvDebug() << "no local tile" << tilePos;
+        onTileFailed(tilePos);
+        return;
+    }
+    onTile(tilePos, createImageTile(tilePos, image, source));
+}
+
+void QGVLayerTilesLocal::removeDecoding(const QGV::GeoTilePos& tilePos)
+{
+    if (!mDecoding.contains(tilePos)) {
+        return;
+    }
+    QGV::getTileDecoder()->cancel(mDecoding.take(tilePos));
+}
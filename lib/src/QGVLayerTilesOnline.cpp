@@ -17,75 +17,366 @@
  ****************************************************************************/
 
 #include "QGVLayerTilesOnline.h"
-#include "Raster/QGVImage.h"
+#include "QGVTileCache.h"
+#include "QGVTileDecoder.h"
+#include "QGVTileDownloader.h"
+#include "QGVTileScheduler.h"
+#include "QGVTileStore.h"
+
+#include <limits>
+
+QGVLayerTilesOnline::QGVLayerTilesOnline()
+    : mServerSharding(QGV::ServerSharding::Disabled)
+{
+}
 
 QGVLayerTilesOnline::~QGVLayerTilesOnline()
 {
-    qDeleteAll(mRequest);
+    for (quint64 ticket : mDownloads) {
+        QGV::getTileDownloader()->cancel(ticket);
+    }
+    for (quint64 ticket : mDecoding) {
+        QGV::getTileDecoder()->cancel(ticket);
+    }
 }
 
-void QGVLayerTilesOnline::request(const QGV::GeoTilePos& tilePos)
+void QGVLayerTilesOnline::setServerSharding(QGV::ServerSharding sharding)
 {
-    Q_ASSERT(QGV::getNetworkManager());
+    mServerSharding = sharding;
+    qgvDebug() << "ServerSharding changed to" << static_cast<int>(sharding);
+}
 
-    const QUrl url(tilePosToUrl(tilePos));
+QGV::ServerSharding QGVLayerTilesOnline::getServerSharding() const
+{
+    return mServerSharding;
+}
+
+int QGVLayerTilesOnline::metatileSize() const
+{
+    return 1;
+}
+
+QString QGVLayerTilesOnline::metatileToUrl(const QGV::GeoTilePos& tilePos, const QSize& /*tiles*/) const
+{
+    return tilePosToUrl(tilePos);
+}
 
-    QNetworkRequest request(url);
-    QSslConfiguration conf = request.sslConfiguration();
-    conf.setPeerVerifyMode(QSslSocket::VerifyNone);
+QSize QGVLayerTilesOnline::metatileTiles(const QGV::GeoTilePos& tilePos) const
+{
+    const int size = qMax(1, metatileSize());
+    const int count = 1 << tilePos.zoom();
+    return QSize(qMin(size, count - tilePos.pos().x()), qMin(size, count - tilePos.pos().y()));
+}
 
-    request.setSslConfiguration(conf);
-    request.setRawHeader("User-Agent",
-                         "Mozilla/5.0 (Windows; U; MSIE "
-                         "6.0; Windows NT 5.1; SV1; .NET "
-                         "CLR 2.0.50727)");
-    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
-    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+QGV::GeoRect QGVLayerTilesOnline::metatileRect(const QGV::GeoTilePos& tilePos) const
+{
+    const QSize tiles = metatileTiles(tilePos);
+    const QGV::GeoRect first = tilePos.toGeoRect();
+    const QGV::GeoRect last =
+            QGV::GeoTilePos(tilePos.zoom(), tilePos.pos() + QPoint(tiles.width() - 1, tiles.height() - 1))
+                    .toGeoRect();
+    return QGV::GeoRect(first.latTop(), first.lonLeft(), last.latBottom(), last.lonRight());
+}
 
-    QNetworkReply* reply = QGV::getNetworkManager()->get(request);
+void QGVLayerTilesOnline::restartRequests()
+{
+    // metatile grid may be changed, so pending work is dropped and tiles are requested again
+    const QMap<QGV::GeoTilePos, QSet<QGV::GeoTilePos>> waiters = mWaiters;
+    for (quint64 ticket : mDownloads) {
+        QGV::getTileDownloader()->cancel(ticket);
+    }
+    for (quint64 ticket : mDecoding) {
+        QGV::getTileDecoder()->cancel(ticket);
+    }
+    mWaiters.clear();
+    mDownloads.clear();
+    mDecoding.clear();
+    for (const QSet<QGV::GeoTilePos>& tiles : waiters) {
+        for (const QGV::GeoTilePos& tilePos : tiles) {
+            addWaiter(tilePos);
+        }
+    }
+    qgvDebug() << "requests restarted for" << waiters.size() << "metatiles";
+}
 
-    mRequest[tilePos] = reply;
-    connect(reply, &QNetworkReply::finished, reply, [this, reply, tilePos]() { onReplyFinished(reply, tilePos); });
+const QGVUrlTemplate& QGVLayerTilesOnline::selectServer(const QGV::GeoTilePos& tilePos,
+                                                        const QVector<QGVUrlTemplate>& servers,
+                                                        int serverNumber) const
+{
+    static const QGVUrlTemplate empty;
+    if (serverNumber < 0 || serverNumber >= servers.size()) {
+        return empty;
+    }
+    if (mServerSharding == QGV::ServerSharding::TileHash) {
+        return servers.at(static_cast<int>(QGV::qHash(tilePos) % static_cast<uint>(servers.size())));
+    }
+    if (mServerSharding == QGV::ServerSharding::LeastOutstanding) {
+        const QGVTileScheduler* scheduler = QGV::getTileScheduler();
+        const auto outstanding = [scheduler](const QGVUrlTemplate& server) {
+            return scheduler->queued(server.getHost()) + scheduler->inFlight(server.getHost());
+        };
+        int best = serverNumber;
+        int bestCount = outstanding(servers.at(best));
+        for (int i = 0; i < servers.size() && bestCount > 0; i++) {
+            const int count = outstanding(servers.at(i));
+            if (count < bestCount) {
+                best = i;
+                bestCount = count;
+            }
+        }
+        return servers.at(best);
+    }
+    return servers.at(serverNumber);
+}
 
-    qgvDebug() << "request" << url;
+void QGVLayerTilesOnline::request(const QGV::GeoTilePos& tilePos)
+{
+    // promoted download keeps its ticket, new priority is applied by one reprioritize() after the whole batch
+    if (mPrefetch.remove(tilePos)) {
+        qgvDebug() << "promote prefetch" << tilePos;
+        return;
+    }
+    addWaiter(tilePos);
 }
 
 void QGVLayerTilesOnline::cancel(const QGV::GeoTilePos& tilePos)
 {
-    removeReply(tilePos);
+    mPrefetch.remove(tilePos);
+    const QGV::GeoTilePos metaPos = metatilePos(tilePos);
+    auto it = mWaiters.find(metaPos);
+    if (it == mWaiters.end()) {
+        return;
+    }
+    it->remove(tilePos);
+    if (!it->isEmpty()) {
+        return;
+    }
+    mWaiters.erase(it);
+    removeDownload(metaPos);
+    removeDecoding(metaPos);
+}
+
+bool QGVLayerTilesOnline::prefetch(const QGV::GeoTilePos& tilePos)
+{
+    if (isPending(tilePos)) {
+        return false;
+    }
+    mPrefetch.insert(tilePos);
+    addWaiter(tilePos);
+    return true;
+}
+
+void QGVLayerTilesOnline::cancelPrefetch(const QGV::GeoTilePos& tilePos)
+{
+    if (!mPrefetch.contains(tilePos)) {
+        return;
+    }
+    cancel(tilePos);
+}
+
+void QGVLayerTilesOnline::reprioritize()
+{
+    QGVTileDownloader* downloader = QGV::getTileDownloader();
+    for (auto it = mDownloads.constBegin(); it != mDownloads.constEnd(); ++it) {
+        downloader->reprioritize(it.value(), metatilePriority(it.key()));
+    }
+}
+
+qreal QGVLayerTilesOnline::metatilePriority(const QGV::GeoTilePos& metaPos) const
+{
+    qreal priority = std::numeric_limits<qreal>::max();
+    for (const QGV::GeoTilePos& tilePos : mWaiters.value(metaPos)) {
+        priority = qMin(priority, tilePriority(tilePos));
+    }
+    return priority;
+}
+
+bool QGVLayerTilesOnline::isPending(const QGV::GeoTilePos& tilePos) const
+{
+    return mWaiters.value(metatilePos(tilePos)).contains(tilePos);
 }
 
-void QGVLayerTilesOnline::onReplyFinished(QNetworkReply* reply, const QGV::GeoTilePos& tilePos)
+QGV::GeoTilePos QGVLayerTilesOnline::metatilePos(const QGV::GeoTilePos& tilePos) const
 {
-    if (reply->error() != QNetworkReply::NoError) {
-        if (reply->error() != QNetworkReply::OperationCanceledError) {
-            qgvCritical() << "ERROR" << reply->errorString();
+    const int size = metatileSize();
+    if (size <= 1) {
+        return tilePos;
+    }
+    const QPoint pos = tilePos.pos();
+    return QGV::GeoTilePos(tilePos.zoom(), QPoint(pos.x() - pos.x() % size, pos.y() - pos.y() % size));
+}
+
+QString QGVLayerTilesOnline::storeId() const
+{
+    const int size = metatileSize();
+    if (size <= 1) {
+        return tilesId();
+    }
+    return tilesId() + QString("#metatile%1").arg(size);
+}
+
+void QGVLayerTilesOnline::addWaiter(const QGV::GeoTilePos& tilePos)
+{
+    const QGV::GeoTilePos metaPos = metatilePos(tilePos);
+    const bool started = mWaiters.contains(metaPos);
+    mWaiters[metaPos].insert(tilePos);
+    if (started) {
+        return;
+    }
+    if (requestFromStore(metaPos)) {
+        return;
+    }
+    requestFromNetwork(metaPos);
+}
+
+void QGVLayerTilesOnline::deliverTile(const QGV::GeoTilePos& tilePos, const QImage& image, const QString& source)
+{
+    if (mPrefetch.remove(tilePos)) {
+        onPrefetch(tilePos, image);
+        return;
+    }
+    onTile(tilePos, createImageTile(tilePos, image, source));
+}
+
+void QGVLayerTilesOnline::deliverMetatile(const QGV::GeoTilePos& metaPos, const QImage& image, const QString& source)
+{
+    const QSet<QGV::GeoTilePos> waiters = mWaiters.take(metaPos);
+    const QSize tiles = metatileTiles(metaPos);
+    if (tiles == QSize(1, 1)) {
+        for (const QGV::GeoTilePos& tilePos : waiters) {
+            deliverTile(tilePos, image, source);
+        }
+        return;
+    }
+    QGVTileCache* cache = QGV::getTileCache();
+    for (int x = 0; x < tiles.width(); x++) {
+        for (int y = 0; y < tiles.height(); y++) {
+            const QGV::GeoTilePos tilePos(metaPos.zoom(), metaPos.pos() + QPoint(x, y));
+            const QImage slice = sliceMetatile(metaPos, image, tilePos);
+            if (waiters.contains(tilePos)) {
+                deliverTile(tilePos, slice, source);
+            } else if (!slice.isNull()) {
+                cache->insert(tilesId(), tilePos, slice);
+            }
+        }
+    }
+}
+
+QImage QGVLayerTilesOnline::sliceMetatile(const QGV::GeoTilePos& metaPos,
+                                          const QImage& image,
+                                          const QGV::GeoTilePos& tilePos) const
+{
+    if (image.isNull()) {
+        return {};
+    }
+    // Metatile image is expected to be linear in longitude and latitude (as WMS GetMap by geographic bbox)
+    const QGV::GeoRect metaRect = metatileRect(metaPos);
+    const QGV::GeoRect tileRect = tilePos.toGeoRect();
+    const double width = metaRect.lonRight() - metaRect.lonLeft();
+    const double height = metaRect.latTop() - metaRect.latBottom();
+    const int left = qRound((tileRect.lonLeft() - metaRect.lonLeft()) / width * image.width());
+    const int right = qRound((tileRect.lonRight() - metaRect.lonLeft()) / width * image.width());
+    const int top = qRound((metaRect.latTop() - tileRect.latTop()) / height * image.height());
+    const int bottom = qRound((metaRect.latTop() - tileRect.latBottom()) / height * image.height());
+    return image.copy(QRect(QPoint(left, top), QPoint(right - 1, bottom - 1)));
+}
+
+bool QGVLayerTilesOnline::requestFromStore(const QGV::GeoTilePos& metaPos)
+{
+    QGVTileStore* store = QGV::getTileStore();
+    if (store == nullptr) {
+        return false;
+    }
+    const QByteArray rawImage = store->load(storeId(), metaPos);
+    if (rawImage.isEmpty()) {
+        return false;
+    }
+    qgvDebug() << "restore from store" << metaPos;
+    decodeTile(metaPos, rawImage, store->getFilePath(), false);
+    return true;
+}
+
+void QGVLayerTilesOnline::requestFromNetwork(const QGV::GeoTilePos& metaPos)
+{
+    const QSize tiles = metatileTiles(metaPos);
+    const QUrl url(tiles == QSize(1, 1) ? tilePosToUrl(metaPos) : metatileToUrl(metaPos, tiles));
+    const auto callback = [this, metaPos, url](QNetworkReply::NetworkError error, const QByteArray& rawImage) {
+        onDownloaded(metaPos, url, error, rawImage);
+    };
+    const quint64 ticket = QGV::getTileDownloader()->get(url, metatilePriority(metaPos), callback);
+    if (ticket == 0) {
+        onDownloadFailed(metaPos);
+        return;
+    }
+    mDownloads[metaPos] = ticket;
+}
+
+void QGVLayerTilesOnline::onDownloaded(const QGV::GeoTilePos& metaPos,
+                                       const QUrl& url,
+                                       QNetworkReply::NetworkError error,
+                                       const QByteArray& rawImage)
+{
+    mDownloads.remove(metaPos);
+    if (error != QNetworkReply::NoError) {
+        onDownloadFailed(metaPos);
+        return;
+    }
+    decodeTile(metaPos, rawImage, url.toString(), true);
+}
+
+void QGVLayerTilesOnline::onDownloadFailed(const QGV::GeoTilePos& metaPos)
+{
+    for (const QGV::GeoTilePos& tilePos : mWaiters.take(metaPos)) {
+        if (mPrefetch.remove(tilePos)) {
+            onPrefetch(tilePos, {});
+        } else {
+            onTileFailed(tilePos);
         }
-        removeReply(tilePos);
+    }
+}
+
+void QGVLayerTilesOnline::decodeTile(const QGV::GeoTilePos& metaPos,
+                                     const QByteArray& rawImage,
+                                     const QString& source,
+                                     bool fromNetwork)
+{
+    mDecoding[metaPos] = QGV::getTileDecoder()->decode(
+            rawImage, [this, metaPos, rawImage, source, fromNetwork](const QImage& image) {
+                onTileDecoded(metaPos, image, rawImage, source, fromNetwork);
+            });
+}
+
+void QGVLayerTilesOnline::onTileDecoded(const QGV::GeoTilePos& metaPos,
+                                        const QImage& image,
+                                        const QByteArray& rawImage,
+                                        const QString& source,
+                                        bool fromNetwork)
+{
+    mDecoding.remove(metaPos);
+    if (!fromNetwork && image.isNull()) {
+        qgvDebug() << "broken tile in store" << metaPos;
+        requestFromNetwork(metaPos);
+        return;
+    }
+    QGVTileStore* store = QGV::getTileStore();
+    if (fromNetwork && store != nullptr && !image.isNull()) {
+        store->save(storeId(), metaPos, rawImage);
+    }
+    deliverMetatile(metaPos, image, source);
+}
+
+void QGVLayerTilesOnline::removeDownload(const QGV::GeoTilePos& metaPos)
+{
+    if (!mDownloads.contains(metaPos)) {
         return;
     }
-    const auto rawImage = reply->readAll();
-    auto tile = new QGVImage();
-    tile->setGeometry(tilePos.toGeoRect());
-    tile->loadImage(rawImage);
-    tile->setProperty("drawDebug",
-                      QString("%1\ntile(%2,%3,%4)")
-                              .arg(reply->url().toString())
-                              .arg(tilePos.zoom())
-                              .arg(tilePos.pos().x())
-                              .arg(tilePos.pos().y()));
-    removeReply(tilePos);
-    onTile(tilePos, tile);
+    QGV::getTileDownloader()->cancel(mDownloads.take(metaPos));
 }
 
-void QGVLayerTilesOnline::removeReply(const QGV::GeoTilePos& tilePos)
+void QGVLayerTilesOnline::removeDecoding(const QGV::GeoTilePos& metaPos)
 {
-    QNetworkReply* reply = mRequest.value(tilePos, nullptr);
-    if (reply == nullptr) {
+    if (!mDecoding.contains(metaPos)) {
         return;
     }
-    mRequest.remove(tilePos);
-    reply->abort();
-    reply->close();
-    reply->deleteLater();
+    QGV::getTileDecoder()->cancel(mDecoding.take(metaPos));
 }
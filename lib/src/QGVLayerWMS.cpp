@@ -0,0 +1,171 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVLayerWMS.h"
+#include "QGVMap.h"
+#include "QGVTileDecoder.h"
+#include "QGVTileDownloader.h"
+#include "Raster/QGVImage.h"
+
+#include <QtMath>
+
+QGVLayerWMS::QGVLayerWMS(const QString& url)
+    : mUrl(url)
+    , mUrlTemplate(mUrl, true)
+    , mMapState(QGV::MapState::Idle)
+    , mImage(new QGVImage())
+    , mDownload(0)
+    , mDecoding(0)
+{
+    setName("WMS");
+    setDescription(url);
+    mImage->setCeilingOnScale(false);
+    addItem(mImage);
+    mTimer.setSingleShot(true);
+    mTimer.setInterval(300);
+    connect(&mTimer, &QTimer::timeout, this, &QGVLayerWMS::request);
+}
+
+QGVLayerWMS::~QGVLayerWMS()
+{
+    cancel();
+}
+
+void QGVLayerWMS::setUrl(const QString& url)
+{
+    mUrl = url;
+    mUrlTemplate.setPattern(mUrl);
+    mLastUrl.clear();
+    mTimer.start();
+}
+
+QString QGVLayerWMS::getUrl() const
+{
+    return mUrl;
+}
+
+void QGVLayerWMS::setUpdateDelay(int msec)
+{
+    mTimer.setInterval(msec);
+    qgvDebug() << "UpdateDelay changed to" << msec;
+}
+
+int QGVLayerWMS::getUpdateDelay() const
+{
+    return mTimer.interval();
+}
+
+QString QGVLayerWMS::viewToUrl(const QGV::GeoRect& geoRect, const QSize& size) const
+{
+    return mUrlTemplate.expand({}, geoRect, size);
+}
+
+void QGVLayerWMS::onProjection(QGVMap* geoMap)
+{
+    QGVLayer::onProjection(geoMap);
+    if (geoMap == nullptr) {
+        return;
+    }
+    connect(geoMap, &QGVMap::stateChanged, this, &QGVLayerWMS::onMapState, Qt::UniqueConnection);
+    mLastUrl.clear();
+    mTimer.start();
+}
+
+void QGVLayerWMS::onCamera(const QGVCameraState& oldState, const QGVCameraState& newState)
+{
+    QGVLayer::onCamera(oldState, newState);
+    if (oldState == newState) {
+        return;
+    }
+    mTimer.start();
+}
+
+void QGVLayerWMS::onMapState(QGV::MapState state)
+{
+    mMapState = state;
+    if (mMapState == QGV::MapState::Idle) {
+        mTimer.start();
+    }
+}
+
+void QGVLayerWMS::request()
+{
+    QGVMap* geoMap = getMap();
+    if (geoMap == nullptr || mMapState != QGV::MapState::Idle) {
+        return;
+    }
+    const QGVCameraState camera = geoMap->getCamera();
+    const QRectF projRect = camera.projRect().intersected(geoMap->getProjection()->boundaryProjRect());
+    if (projRect.isEmpty()) {
+        return;
+    }
+    const double pixelFactor = camera.scale() * geoMap->devicePixelRatioF();
+    const QSize size(qCeil(projRect.width() * pixelFactor), qCeil(projRect.height() * pixelFactor));
+    const QGV::GeoRect geoRect = geoMap->getProjection()->projToGeo(projRect);
+    const QString url = viewToUrl(geoRect, size);
+    if (url == mLastUrl) {
+        return;
+    }
+    cancel();
+    mLastUrl = url;
+    qgvDebug() << "request view" << geoRect << size;
+    const auto callback = [this, geoRect](QNetworkReply::NetworkError error, const QByteArray& rawImage) {
+        onDownloaded(geoRect, error, rawImage);
+    };
+    mDownload = QGV::getTileDownloader()->get(QUrl(url), 0, callback);
+    if (mDownload == 0) {
+        mLastUrl.clear();
+    }
+}
+
+void QGVLayerWMS::cancel()
+{
+    if (mDownload != 0) {
+        QGV::getTileDownloader()->cancel(mDownload);
+        mDownload = 0;
+    }
+    if (mDecoding != 0) {
+        QGV::getTileDecoder()->cancel(mDecoding);
+        mDecoding = 0;
+    }
+}
+
+void QGVLayerWMS::onDownloaded(const QGV::GeoRect& geoRect,
+                               QNetworkReply::NetworkError error,
+                               const QByteArray& rawImage)
+{
+    mDownload = 0;
+    if (error != QNetworkReply::NoError) {
+        mLastUrl.clear();
+        return;
+    }
+    mDecoding = QGV::getTileDecoder()->decode(rawImage, [this, geoRect](const QImage& image) {
+        onImageDecoded(geoRect, image);
+    });
+}
+
+void QGVLayerWMS::onImageDecoded(const QGV::GeoRect& geoRect, const QImage& image)
+{
+    mDecoding = 0;
+    if (image.isNull()) {
+        mLastUrl.clear();
+        return;
+    }
+    mImage->setGeometry(geoRect);
+    mImage->loadImage(image);
+}
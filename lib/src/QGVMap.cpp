@@ -17,15 +17,19 @@
  ****************************************************************************/
 
 #include "QGVMap.h"
+#include "QGVDrawItem.h"
 #include "QGVItem.h"
-#include "QGVMapQGItem.h"
 #include "QGVMapQGView.h"
 #include "QGVProjectionEPSG3857.h"
+#include "QGVSpatialIndex.h"
 #include "QGVWidget.h"
 
 #include <QMouseEvent>
 #include <QVBoxLayout>
 
+#include <algorithm>
+#include <functional>
+
 class RootItem : public QGVItem
 {
 public:
@@ -45,9 +49,53 @@ private:
 };
 RootItem::~RootItem() = default;
 
+namespace {
+bool isBoundingMode(Qt::ItemSelectionMode mode)
+{
+    return mode == Qt::ContainsItemBoundingRect || mode == Qt::IntersectsItemBoundingRect;
+}
+
+bool isContainsMode(Qt::ItemSelectionMode mode)
+{
+    return mode == Qt::ContainsItemShape || mode == Qt::ContainsItemBoundingRect;
+}
+
+QPainterPath itemPath(QGVDrawItem* item, Qt::ItemSelectionMode mode)
+{
+    const QPainterPath shape = item->effectiveTransform().map(item->projShape());
+    if (!isBoundingMode(mode)) {
+        return shape;
+    }
+    QPainterPath path;
+    path.addRect(shape.boundingRect());
+    return path;
+}
+
+QList<QGVDrawItem*> filterItems(const QList<QGVDrawItem*>& candidates, std::function<bool(QGVDrawItem*)> predicate)
+{
+    QList<QGVDrawItem*> result;
+    for (QGVDrawItem* item : candidates) {
+        if (item->effectivelyVisible() && predicate(item)) {
+            result.append(item);
+        }
+    }
+    // Same order as QGraphicsScene returns: top item first
+    std::stable_sort(result.begin(), result.end(), [](QGVDrawItem* item1, QGVDrawItem* item2) {
+        return item1->effectiveZValue() > item2->effectiveZValue();
+    });
+    return result;
+}
+}
+
 QGVMap::QGVMap(QWidget* parent)
     : QWidget(parent)
+    , mDeferredUpdates(false)
+    , mFlushing(false)
 {
+    mSpatialIndex.reset(new QGVSpatialIndex());
+    mUpdateTimer.setSingleShot(true);
+    mUpdateTimer.setInterval(0);
+    connect(&mUpdateTimer, &QTimer::timeout, this, &QGVMap::flushUpdates);
     mProjection.reset(new QGVProjectionEPSG3857());
     mQGView.reset(new QGVMapQGView(this));
     mRootItem.reset(new RootItem(this));
@@ -60,6 +108,11 @@ QGVMap::QGVMap(QWidget* parent)
 
 QGVMap::~QGVMap()
 {
+    mUpdateTimer.stop();
+    for (QGVItem* item : mDirtyItems) {
+        item->mUpdateMap = nullptr;
+    }
+    mDirtyItems.clear();
     deleteItems();
     deleteWidgets();
 }
@@ -139,6 +192,11 @@ QGVMapQGView* QGVMap::geoView() const
     return mQGView.data();
 }
 
+QGVSpatialIndex* QGVMap::spatialIndex() const
+{
+    return mSpatialIndex.data();
+}
+
 void QGVMap::addItem(QGVItem* item)
 {
     Q_ASSERT(item);
@@ -151,6 +209,16 @@ void QGVMap::removeItem(QGVItem* item)
     mRootItem->removeItem(item);
 }
 
+void QGVMap::addItems(const QList<QGVItem*>& items)
+{
+    mRootItem->addItems(items);
+}
+
+void QGVMap::removeItems(const QList<QGVItem*>& items)
+{
+    mRootItem->removeItems(items);
+}
+
 void QGVMap::deleteItems()
 {
     mRootItem->deleteItems();
@@ -235,35 +303,43 @@ QSet<QGVItem*> QGVMap::getSelections() const
 
 QList<QGVDrawItem*> QGVMap::search(const QPointF& projPos, Qt::ItemSelectionMode mode) const
 {
-    QList<QGVDrawItem*> result;
-    for (QGraphicsItem* item : geoView()->scene()->items(projPos, mode)) {
-        QGVDrawItem* geoObject = QGVMapQGItem::geoObjectFromQGItem(item);
-        if (geoObject)
-            result << geoObject;
-    }
-    return result;
+    return filterItems(mSpatialIndex->search(projPos), [&projPos, mode](QGVDrawItem* item) {
+        return itemPath(item, mode).contains(projPos);
+    });
 }
 
 QList<QGVDrawItem*> QGVMap::search(const QRectF& projRect, Qt::ItemSelectionMode mode) const
 {
-    QList<QGVDrawItem*> result;
-    for (QGraphicsItem* item : geoView()->scene()->items(projRect, mode)) {
-        QGVDrawItem* geoObject = QGVMapQGItem::geoObjectFromQGItem(item);
-        if (geoObject)
-            result << geoObject;
-    }
-    return result;
+    return search(QPolygonF(projRect), mode);
 }
 
 QList<QGVDrawItem*> QGVMap::search(const QPolygonF& projPolygon, Qt::ItemSelectionMode mode) const
+{
+    QPainterPath area;
+    area.addPolygon(projPolygon);
+    area.closeSubpath();
+    return filterItems(mSpatialIndex->search(projPolygon.boundingRect()), [&area, mode](QGVDrawItem* item) {
+        const QPainterPath path = itemPath(item, mode);
+        return isContainsMode(mode) ? area.contains(path) : area.intersects(path);
+    });
+}
+
+QList<QGVDrawItem*> QGVMap::searchNearest(const QPointF& projPos, int count) const
 {
     QList<QGVDrawItem*> result;
-    for (QGraphicsItem* item : geoView()->scene()->items(projPolygon, mode)) {
-        QGVDrawItem* geoObject = QGVMapQGItem::geoObjectFromQGItem(item);
-        if (geoObject)
-            result << geoObject;
+    for (int limit = count; limit > 0; limit *= 2) {
+        const auto candidates = mSpatialIndex->nearest(projPos, limit);
+        result.clear();
+        for (QGVDrawItem* item : candidates) {
+            if (item->effectivelyVisible()) {
+                result.append(item);
+            }
+        }
+        if (result.size() >= count || candidates.size() < limit) {
+            break;
+        }
     }
-    return result;
+    return result.mid(0, count);
 }
 
 QPixmap QGVMap::grabMapView(bool includeWidgets) const
@@ -287,6 +363,62 @@ QPoint QGVMap::mapFromProj(QPointF projPos)
     return mapPos;
 }
 
+void QGVMap::setDeferredUpdates(bool enabled)
+{
+    if (mDeferredUpdates == enabled) {
+        return;
+    }
+    mDeferredUpdates = enabled;
+    if (!mDeferredUpdates) {
+        flushUpdates();
+    }
+}
+
+bool QGVMap::isDeferredUpdates() const
+{
+    return mDeferredUpdates;
+}
+
+void QGVMap::flushUpdates()
+{
+    if (mFlushing) {
+        return;
+    }
+    mUpdateTimer.stop();
+    mFlushing = true;
+    while (!mDirtyItems.isEmpty()) {
+        auto it = mDirtyItems.begin();
+        QGVItem* item = *it;
+        mDirtyItems.erase(it);
+        item->mUpdateMap = nullptr;
+        if (item->getMap() != this) {
+            continue;
+        }
+        // Pending ancestor will update whole subtree
+        bool covered = false;
+        for (QGVItem* obj = item->getParent(); obj != nullptr && !covered; obj = obj->getParent()) {
+            covered = (obj->mUpdateMap != nullptr);
+        }
+        if (!covered) {
+            item->updateNow();
+        }
+    }
+    mFlushing = false;
+}
+
+void QGVMap::scheduleUpdate(QGVItem* item)
+{
+    mDirtyItems.insert(item);
+    if (!mUpdateTimer.isActive()) {
+        mUpdateTimer.start();
+    }
+}
+
+void QGVMap::cancelUpdate(QGVItem* item)
+{
+    mDirtyItems.remove(item);
+}
+
 void QGVMap::refreshMap()
 {
     mRootItem->update();
@@ -364,6 +496,14 @@ void QGVMap::onMapCamera(const QGVCameraState& oldState, const QGVCameraState& n
     }
 }
 
+void QGVMap::onMapCameraPlan(const QList<QGVCameraState>& plan)
+{
+    auto root = static_cast<RootItem*>(rootItem());
+    if (root->isVisible()) {
+        root->onCameraPlan(plan);
+    }
+}
+
 void QGVMap::mouseMoveEvent(QMouseEvent* event)
 {
     if (hasMouseTracking()) {
@@ -82,7 +82,7 @@ QGV::MouseActions QGVMapQGView::getMouseActions() const
 QGVCameraState QGVMapQGView::getCamera() const
 {
     const bool animation = mState == QGV::MapState::Animation;
-    return QGVCameraState(mGeoMap, mAzimuth, mScale, viewRect(), animation);
+    return QGVCameraState(mGeoMap, mAzimuth, mScale, mapToScene(mViewRect), animation);
 }
 
 void QGVMapQGView::cameraTo(const QGVCameraActions& actions, bool animation)
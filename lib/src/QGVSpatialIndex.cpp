@@ -0,0 +1,434 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVSpatialIndex.h"
+
+#include <QtMath>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace {
+const int maxChildren = 16;
+
+QRectF unite(const QRectF& rect1, const QRectF& rect2)
+{
+    return QRectF(QPointF(qMin(rect1.left(), rect2.left()), qMin(rect1.top(), rect2.top())),
+                  QPointF(qMax(rect1.right(), rect2.right()), qMax(rect1.bottom(), rect2.bottom())));
+}
+
+bool overlaps(const QRectF& rect1, const QRectF& rect2)
+{
+    return rect1.left() <= rect2.right() && rect2.left() <= rect1.right() && rect1.top() <= rect2.bottom() &&
+           rect2.top() <= rect1.bottom();
+}
+
+double area(const QRectF& rect)
+{
+    return rect.width() * rect.height();
+}
+
+double distance2(const QRectF& rect, const QPointF& pos)
+{
+    const double dx = qMax(0.0, qMax(rect.left() - pos.x(), pos.x() - rect.right()));
+    const double dy = qMax(0.0, qMax(rect.top() - pos.y(), pos.y() - rect.bottom()));
+    return dx * dx + dy * dy;
+}
+
+struct Candidate
+{
+    double distance;
+    int index;
+    bool entry;
+
+    bool operator>(const Candidate& other) const
+    {
+        return distance > other.distance;
+    }
+};
+}
+
+QGVSpatialIndex::QGVSpatialIndex()
+    : mRoot(-1)
+{
+}
+
+void QGVSpatialIndex::load(const QVector<QPair<QGVDrawItem*, QRectF>>& items)
+{
+    clear();
+    mEntries.reserve(items.size());
+    mItems.reserve(items.size());
+    for (const auto& pair : items) {
+        insert(pair.first, pair.second);
+    }
+    build();
+}
+
+void QGVSpatialIndex::insert(QGVDrawItem* item, const QRectF& projRect)
+{
+    Q_ASSERT(item);
+    const QRectF rect = projRect.normalized();
+    auto it = mItems.find(item);
+    if (it != mItems.end()) {
+        Entry& entry = mEntries[it.value()];
+        if (entry.rect == rect) {
+            return;
+        }
+        removeEntry(it.value());
+        mEntries[it.value()].rect = rect;
+        mPending.insert(it.value());
+        return;
+    }
+    int index;
+    if (!mFreeEntries.isEmpty()) {
+        index = mFreeEntries.takeLast();
+    } else {
+        index = mEntries.size();
+        mEntries.append(Entry());
+    }
+    mEntries[index] = { rect, item, -1 };
+    mItems.insert(item, index);
+    mPending.insert(index);
+}
+
+void QGVSpatialIndex::remove(QGVDrawItem* item)
+{
+    auto it = mItems.find(item);
+    if (it == mItems.end()) {
+        return;
+    }
+    const int index = it.value();
+    mItems.erase(it);
+    if (!mPending.remove(index)) {
+        removeEntry(index);
+    }
+    mEntries[index] = { QRectF(), nullptr, -1 };
+    mFreeEntries.append(index);
+}
+
+void QGVSpatialIndex::clear()
+{
+    mRoot = -1;
+    mNodes.clear();
+    mFreeNodes.clear();
+    mEntries.clear();
+    mFreeEntries.clear();
+    mItems.clear();
+    mPending.clear();
+}
+
+bool QGVSpatialIndex::contains(QGVDrawItem* item) const
+{
+    return mItems.contains(item);
+}
+
+QRectF QGVSpatialIndex::bounds(QGVDrawItem* item) const
+{
+    auto it = mItems.find(item);
+    if (it == mItems.end()) {
+        return {};
+    }
+    return mEntries.at(it.value()).rect;
+}
+
+int QGVSpatialIndex::count() const
+{
+    return mItems.size();
+}
+
+QList<QGVDrawItem*> QGVSpatialIndex::search(const QPointF& projPos)
+{
+    return search(QRectF(projPos, projPos));
+}
+
+QList<QGVDrawItem*> QGVSpatialIndex::search(const QRectF& projRect)
+{
+    flush();
+    QList<QGVDrawItem*> result;
+    if (mRoot < 0) {
+        return result;
+    }
+    const QRectF rect = projRect.normalized();
+    QVector<int> stack;
+    stack.append(mRoot);
+    while (!stack.isEmpty()) {
+        const Node& node = mNodes.at(stack.takeLast());
+        if (!overlaps(node.rect, rect)) {
+            continue;
+        }
+        for (int child : node.children) {
+            if (node.leaf) {
+                const Entry& entry = mEntries.at(child);
+                if (overlaps(entry.rect, rect)) {
+                    result.append(entry.item);
+                }
+            } else {
+                stack.append(child);
+            }
+        }
+    }
+    return result;
+}
+
+QList<QGVDrawItem*> QGVSpatialIndex::nearest(const QPointF& projPos, int count)
+{
+    flush();
+    QList<QGVDrawItem*> result;
+    if (mRoot < 0 || count <= 0) {
+        return result;
+    }
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+    queue.push({ distance2(mNodes.at(mRoot).rect, projPos), mRoot, false });
+    while (!queue.empty() && result.size() < count) {
+        const Candidate candidate = queue.top();
+        queue.pop();
+        if (candidate.entry) {
+            result.append(mEntries.at(candidate.index).item);
+            continue;
+        }
+        const Node& node = mNodes.at(candidate.index);
+        for (int child : node.children) {
+            queue.push({ distance2(childRect(candidate.index, child), projPos), child, node.leaf });
+        }
+    }
+    return result;
+}
+
+int QGVSpatialIndex::newNode(bool leaf)
+{
+    int index;
+    if (!mFreeNodes.isEmpty()) {
+        index = mFreeNodes.takeLast();
+    } else {
+        index = mNodes.size();
+        mNodes.append(Node());
+    }
+    Node& node = mNodes[index];
+    node.rect = QRectF();
+    node.parent = -1;
+    node.leaf = leaf;
+    node.children.clear();
+    return index;
+}
+
+void QGVSpatialIndex::freeNode(int node)
+{
+    mNodes[node].children.clear();
+    mFreeNodes.append(node);
+}
+
+QRectF QGVSpatialIndex::childRect(int node, int child) const
+{
+    return mNodes.at(node).leaf ? mEntries.at(child).rect : mNodes.at(child).rect;
+}
+
+void QGVSpatialIndex::attachChild(int node, int child)
+{
+    mNodes[node].children.append(child);
+    if (mNodes.at(node).leaf) {
+        mEntries[child].node = node;
+    } else {
+        mNodes[child].parent = node;
+    }
+}
+
+void QGVSpatialIndex::recalc(int node)
+{
+    const Node& item = mNodes.at(node);
+    QRectF rect;
+    for (int i = 0; i < item.children.size(); i++) {
+        const QRectF childBounds = childRect(node, item.children.at(i));
+        rect = (i == 0) ? childBounds : unite(rect, childBounds);
+    }
+    mNodes[node].rect = rect;
+}
+
+void QGVSpatialIndex::tighten(int node)
+{
+    while (node >= 0) {
+        const QRectF oldRect = mNodes.at(node).rect;
+        recalc(node);
+        if (mNodes.at(node).rect == oldRect) {
+            break;
+        }
+        node = mNodes.at(node).parent;
+    }
+}
+
+int QGVSpatialIndex::chooseLeaf(const QRectF& rect) const
+{
+    int node = mRoot;
+    while (!mNodes.at(node).leaf) {
+        int best = -1;
+        double bestGrowth = 0;
+        double bestArea = 0;
+        for (int child : mNodes.at(node).children) {
+            const QRectF& childBounds = mNodes.at(child).rect;
+            const double childArea = area(childBounds);
+            const double growth = area(unite(childBounds, rect)) - childArea;
+            if (best < 0 || growth < bestGrowth || (growth == bestGrowth && childArea < bestArea)) {
+                best = child;
+                bestGrowth = growth;
+                bestArea = childArea;
+            }
+        }
+        node = best;
+    }
+    return node;
+}
+
+int QGVSpatialIndex::split(int node)
+{
+    // Median split along the longest side of node
+    QVector<int> children = mNodes.at(node).children;
+    const QRectF rect = mNodes.at(node).rect;
+    const bool byX = rect.width() >= rect.height();
+    std::sort(children.begin(), children.end(), [this, node, byX](int child1, int child2) {
+        const QPointF center1 = childRect(node, child1).center();
+        const QPointF center2 = childRect(node, child2).center();
+        return byX ? center1.x() < center2.x() : center1.y() < center2.y();
+    });
+    const int sibling = newNode(mNodes.at(node).leaf);
+    const int half = children.size() / 2;
+    mNodes[node].children.clear();
+    for (int i = 0; i < children.size(); i++) {
+        attachChild((i < half) ? node : sibling, children.at(i));
+    }
+    recalc(node);
+    recalc(sibling);
+    return sibling;
+}
+
+void QGVSpatialIndex::insertEntry(int entry)
+{
+    if (mRoot < 0) {
+        mRoot = newNode(true);
+    }
+    int node = chooseLeaf(mEntries.at(entry).rect);
+    attachChild(node, entry);
+    while (node >= 0) {
+        if (mNodes.at(node).children.size() > maxChildren) {
+            const int sibling = split(node);
+            int parent = mNodes.at(node).parent;
+            if (parent < 0) {
+                parent = newNode(false);
+                attachChild(parent, node);
+                mRoot = parent;
+            }
+            attachChild(parent, sibling);
+        }
+        recalc(node);
+        node = mNodes.at(node).parent;
+    }
+}
+
+void QGVSpatialIndex::removeEntry(int entry)
+{
+    int node = mEntries.at(entry).node;
+    if (node < 0) {
+        return;
+    }
+    mNodes[node].children.removeOne(entry);
+    mEntries[entry].node = -1;
+    while (node != mRoot && mNodes.at(node).children.isEmpty()) {
+        const int parent = mNodes.at(node).parent;
+        mNodes[parent].children.removeOne(node);
+        freeNode(node);
+        node = parent;
+    }
+    tighten(node);
+    while (!mNodes.at(mRoot).leaf && mNodes.at(mRoot).children.size() == 1) {
+        const int root = mRoot;
+        mRoot = mNodes.at(root).children.first();
+        mNodes[mRoot].parent = -1;
+        freeNode(root);
+    }
+}
+
+QVector<int> QGVSpatialIndex::pack(QVector<int> children, bool leaf)
+{
+    const int nodeCount = (children.size() + maxChildren - 1) / maxChildren;
+    const int sliceSize = qCeil(qSqrt(nodeCount)) * maxChildren;
+    auto byX = [this, leaf](int child1, int child2) {
+        const QRectF& rect1 = leaf ? mEntries.at(child1).rect : mNodes.at(child1).rect;
+        const QRectF& rect2 = leaf ? mEntries.at(child2).rect : mNodes.at(child2).rect;
+        return rect1.center().x() < rect2.center().x();
+    };
+    auto byY = [this, leaf](int child1, int child2) {
+        const QRectF& rect1 = leaf ? mEntries.at(child1).rect : mNodes.at(child1).rect;
+        const QRectF& rect2 = leaf ? mEntries.at(child2).rect : mNodes.at(child2).rect;
+        return rect1.center().y() < rect2.center().y();
+    };
+    std::sort(children.begin(), children.end(), byX);
+    QVector<int> result;
+    result.reserve(nodeCount);
+    for (int slice = 0; slice < children.size(); slice += sliceSize) {
+        const int sliceEnd = qMin(slice + sliceSize, children.size());
+        std::sort(children.begin() + slice, children.begin() + sliceEnd, byY);
+        for (int first = slice; first < sliceEnd; first += maxChildren) {
+            const int node = newNode(leaf);
+            const int last = qMin(first + maxChildren, sliceEnd);
+            for (int i = first; i < last; i++) {
+                attachChild(node, children.at(i));
+            }
+            recalc(node);
+            result.append(node);
+        }
+    }
+    return result;
+}
+
+void QGVSpatialIndex::build()
+{
+    mRoot = -1;
+    mNodes.clear();
+    mFreeNodes.clear();
+    mPending.clear();
+    QVector<int> level;
+    level.reserve(mItems.size());
+    for (int index : mItems) {
+        level.append(index);
+    }
+    if (level.isEmpty()) {
+        return;
+    }
+    mNodes.reserve(level.size() / maxChildren * 2 + 1);
+    bool leaf = true;
+    do {
+        level = pack(level, leaf);
+        leaf = false;
+    } while (level.size() > 1);
+    mRoot = level.first();
+}
+
+void QGVSpatialIndex::flush()
+{
+    if (mPending.isEmpty()) {
+        return;
+    }
+    // Repacking is cheaper and gives better tree than many single inserts
+    if (mRoot < 0 || mPending.size() * 4 > mItems.size()) {
+        build();
+        return;
+    }
+    for (int entry : mPending) {
+        insertEntry(entry);
+    }
+    mPending.clear();
+}
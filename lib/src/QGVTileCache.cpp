@@ -0,0 +1,118 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVTileCache.h"
+
+#include <limits>
+
+namespace {
+// QCache cost is int, so budget is counted in KiB to allow large caches
+const qint64 CostUnit = 1024;
+const qint64 DefaultMaxBytes = 128 * 1024 * 1024;
+
+int imageCost(const QImage& image)
+{
+    const qint64 bytes = static_cast<qint64>(image.bytesPerLine()) * image.height();
+    return static_cast<int>(qMax(qint64(1), bytes / CostUnit));
+}
+}
+
+QGVTileCache::QGVTileCache()
+    : mHits(0)
+    , mMisses(0)
+{
+    setMaxBytes(DefaultMaxBytes);
+}
+
+void QGVTileCache::setMaxBytes(qint64 maxBytes)
+{
+    const qint64 maxCost = qBound(qint64(0), maxBytes / CostUnit, qint64(std::numeric_limits<int>::max()));
+    mCache.setMaxCost(static_cast<int>(maxCost));
+    qgvDebug() << "tile cache budget changed to" << maxBytes;
+}
+
+qint64 QGVTileCache::getMaxBytes() const
+{
+    return static_cast<qint64>(mCache.maxCost()) * CostUnit;
+}
+
+qint64 QGVTileCache::getUsedBytes() const
+{
+    return static_cast<qint64>(mCache.totalCost()) * CostUnit;
+}
+
+int QGVTileCache::count() const
+{
+    return static_cast<int>(mCache.count());
+}
+
+bool QGVTileCache::contains(const QString& layerId, const QGV::GeoTilePos& tilePos) const
+{
+    return mCache.contains(Key(layerId, tilePos));
+}
+
+QImage QGVTileCache::find(const QString& layerId, const QGV::GeoTilePos& tilePos)
+{
+    const QImage* image = mCache.object(Key(layerId, tilePos));
+    if (image == nullptr) {
+        mMisses++;
+        return {};
+    }
+    mHits++;
+    return *image;
+}
+
+QImage QGVTileCache::peek(const QString& layerId, const QGV::GeoTilePos& tilePos) const
+{
+    const QImage* image = mCache.object(Key(layerId, tilePos));
+    return (image != nullptr) ? *image : QImage();
+}
+
+void QGVTileCache::insert(const QString& layerId, const QGV::GeoTilePos& tilePos, const QImage& image)
+{
+    if (image.isNull()) {
+        return;
+    }
+    mCache.insert(Key(layerId, tilePos), new QImage(image), imageCost(image));
+}
+
+void QGVTileCache::remove(const QString& layerId, const QGV::GeoTilePos& tilePos)
+{
+    mCache.remove(Key(layerId, tilePos));
+}
+
+void QGVTileCache::clear()
+{
+    mCache.clear();
+}
+
+quint64 QGVTileCache::hits() const
+{
+    return mHits;
+}
+
+quint64 QGVTileCache::misses() const
+{
+    return mMisses;
+}
+
+void QGVTileCache::resetCounters()
+{
+    mHits = 0;
+    mMisses = 0;
+}
@@ -0,0 +1,164 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+
+#include "QGVTileDecoder.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+class QGVTileDecoder::Task : public QRunnable
+{
+public:
+    Task(QGVTileDecoder* decoder, const QByteArray& rawData, const QString& filePath)
+        : mDecoder(decoder)
+        , mTicket(0)
+        , mRawData(rawData)
+        , mFilePath(filePath)
+    {
+    }
+
+    void setTicket(quint64 ticket)
+    {
+        mTicket = ticket;
+    }
+
+    void run() override
+    {
+        if (!mDecoder->isActive(mTicket)) {
+            return;
+        }
+        QImage image;
+        if (mFilePath.isEmpty()) {
+            image.loadFromData(mRawData);
+        } else {
+            loadFile(image);
+        }
+        if (!image.isNull() && image.format() != QImage::Format_RGB32 &&
+            image.format() != QImage::Format_ARGB32_Premultiplied) {
+            image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        }
+        Q_EMIT mDecoder->decoded(mTicket, image);
+    }
+
+private:
+    void loadFile(QImage& image) const
+    {
+        QFile file(mFilePath);
+        if (!file.open(QIODevice::ReadOnly) || file.size() <= 0) {
+            return;
+        }
+        const qint64 size = file.size();
+        uchar* data = file.map(0, size);
+        if (data != nullptr) {
+            image.loadFromData(data, static_cast<int>(size));
+            file.unmap(data);
+        } else {
+            image.loadFromData(file.readAll());
+        }
+    }
+
+private:
+    QGVTileDecoder* mDecoder;
+    quint64 mTicket;
+    QByteArray mRawData;
+    QString mFilePath;
+};
+
+QGVTileDecoder::QGVTileDecoder(QObject* parent)
+    : QObject(parent)
+    , mTicket(0)
+{
+    setMaxThreads(qBound(1, QThread::idealThreadCount() - 1, 4));
+    connect(this, &QGVTileDecoder::decoded, this, &QGVTileDecoder::onDecoded, Qt::QueuedConnection);
+}
+
+QGVTileDecoder::~QGVTileDecoder()
+{
+    {
+        QMutexLocker locker(&mMutex);
+        mCallbacks.clear();
+    }
+    mPool.clear();
+    mPool.waitForDone();
+}
+
+void QGVTileDecoder::setMaxThreads(int count)
+{
+    mPool.setMaxThreadCount(qMax(1, count));
+    qgvDebug() << "tile decoder threads changed to" << mPool.maxThreadCount();
+}
+
+int QGVTileDecoder::getMaxThreads() const
+{
+    return mPool.maxThreadCount();
+}
+
+int QGVTileDecoder::count() const
+{
+    QMutexLocker locker(&mMutex);
+    return mCallbacks.size();
+}
+
+quint64 QGVTileDecoder::decode(const QByteArray& rawData, const Callback& callback)
+{
+    return start(new Task(this, rawData, {}), callback);
+}
+
+quint64 QGVTileDecoder::decodeFile(const QString& filePath, const Callback& callback)
+{
+    return start(new Task(this, {}, filePath), callback);
+}
+
+quint64 QGVTileDecoder::start(Task* task, const Callback& callback)
+{
+    const quint64 ticket = ++mTicket;
+    {
+        QMutexLocker locker(&mMutex);
+        mCallbacks.insert(ticket, callback);
+    }
+    task->setTicket(ticket);
+    mPool.start(task);
+    return ticket;
+}
+
+void QGVTileDecoder::cancel(quint64 ticket)
+{
+    QMutexLocker locker(&mMutex);
+    mCallbacks.remove(ticket);
+}
+
+bool QGVTileDecoder::isActive(quint64 ticket) const
+{
+    QMutexLocker locker(&mMutex);
+    return mCallbacks.contains(ticket);
+}
+
+void QGVTileDecoder::onDecoded(quint64 ticket, const QImage& image)
+{
+    Callback callback;
+    {
+        QMutexLocker locker(&mMutex);
+        callback = mCallbacks.take(ticket);
+    }
+    if (callback) {
+        callback(image);
+    }
+}
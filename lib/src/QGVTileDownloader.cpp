@@ -0,0 +1,222 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+
+#include "QGVTileDownloader.h"
+#include "QGVTileScheduler.h"
+
+#include <QNetworkAccessManager>
+#include <QSslConfiguration>
+
+namespace {
+const qint64 DefaultBackoffInitialMs = 2000;
+const qint64 DefaultBackoffMaxMs = 5 * 60 * 1000;
+const int FailuresLimit = 4096;
+}
+
+QGVTileDownloader::QGVTileDownloader(QObject* parent)
+    : QObject(parent)
+    , mBackoffInitialMs(DefaultBackoffInitialMs)
+    , mBackoffMaxMs(DefaultBackoffMaxMs)
+    , mTicket(0)
+{
+    mClock.start();
+}
+
+QGVTileDownloader::~QGVTileDownloader()
+{
+    for (Job& job : mJobs) {
+        if (!job.reply.isNull()) {
+            disconnect(job.reply.data(), nullptr, this, nullptr);
+            job.reply->abort();
+            delete job.reply.data();
+        }
+    }
+}
+
+void QGVTileDownloader::setBackoffMs(qint64 initialMs, qint64 maxMs)
+{
+    mBackoffInitialMs = qMax(qint64(0), initialMs);
+    mBackoffMaxMs = qMax(mBackoffInitialMs, maxMs);
+    qgvDebug() << "tile backoff changed to" << mBackoffInitialMs << mBackoffMaxMs;
+}
+
+int QGVTileDownloader::count() const
+{
+    return static_cast<int>(mJobs.size());
+}
+
+bool QGVTileDownloader::isBackoff(const QUrl& url) const
+{
+    auto it = mFailures.constFind(url.toString());
+    return it != mFailures.constEnd() && mClock.elapsed() < it->retryAt;
+}
+
+quint64 QGVTileDownloader::get(const QUrl& url, qreal priority, const Callback& callback)
+{
+    if (isBackoff(url)) {
+        qgvDebug() << "backoff" << url;
+        return 0;
+    }
+    const QString key = url.toString();
+    auto it = mJobs.find(key);
+    if (it == mJobs.end()) {
+        Job job;
+        job.url = url;
+        job.schedule = QGV::getTileScheduler()->enqueue(url.host(), priority, [this, key]() { start(key); });
+        it = mJobs.insert(key, job);
+        qgvDebug() << "schedule" << url;
+    } else {
+        qgvDebug() << "join in-flight" << url;
+    }
+    const quint64 ticket = ++mTicket;
+    mTickets.insert(ticket, key);
+    it->waiters.insert(ticket, callback);
+    it->priorities.insert(ticket, priority);
+    updatePriority(it.value());
+    return ticket;
+}
+
+void QGVTileDownloader::reprioritize(quint64 ticket, qreal priority)
+{
+    auto it = mJobs.find(mTickets.value(ticket));
+    if (it == mJobs.end()) {
+        return;
+    }
+    it->priorities[ticket] = priority;
+    updatePriority(it.value());
+}
+
+void QGVTileDownloader::cancel(quint64 ticket)
+{
+    auto it = mJobs.find(mTickets.take(ticket));
+    if (it == mJobs.end()) {
+        return;
+    }
+    it->waiters.remove(ticket);
+    it->priorities.remove(ticket);
+    if (!it->waiters.isEmpty()) {
+        updatePriority(it.value());
+        return;
+    }
+    Job job = it.value();
+    mJobs.erase(it);
+    abort(job);
+}
+
+void QGVTileDownloader::start(const QString& key)
+{
+    auto it = mJobs.find(key);
+    if (it == mJobs.end()) {
+        return;
+    }
+    Q_ASSERT(QGV::getNetworkManager());
+
+    QNetworkRequest request(it->url);
+    QSslConfiguration conf = request.sslConfiguration();
+    conf.setPeerVerifyMode(QSslSocket::VerifyNone);
+
+    request.setSslConfiguration(conf);
+    request.setRawHeader("User-Agent",
+                         "Mozilla/5.0 (Windows; U; MSIE "
+                         "6.0; Windows NT 5.1; SV1; .NET "
+                         "CLR 2.0.50727)");
+    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+
+    QNetworkReply* reply = QGV::getNetworkManager()->get(request);
+    it->reply = reply;
+    connect(reply, &QNetworkReply::finished, this, [this, key, reply]() { onFinished(key, reply); });
+
+    qgvDebug() << "request" << it->url;
+}
+
+void QGVTileDownloader::onFinished(const QString& key, QNetworkReply* reply)
+{
+    reply->deleteLater();
+    auto it = mJobs.find(key);
+    if (it == mJobs.end() || it->reply.data() != reply) {
+        return;
+    }
+    const Job job = it.value();
+    mJobs.erase(it);
+    QGV::getTileScheduler()->finish(job.schedule);
+
+    const QNetworkReply::NetworkError error = reply->error();
+    QByteArray rawData;
+    if (error == QNetworkReply::NoError) {
+        mFailures.remove(key);
+        rawData = reply->readAll();
+    } else if (error != QNetworkReply::OperationCanceledError) {
+        qgvCritical() << "ERROR" << reply->errorString();
+        onFailure(key);
+    }
+    for (auto waiter = job.waiters.constBegin(); waiter != job.waiters.constEnd(); ++waiter) {
+        // waiter can be cancelled by previous callback
+        if (mTickets.remove(waiter.key()) == 0) {
+            continue;
+        }
+        waiter.value()(error, rawData);
+    }
+}
+
+void QGVTileDownloader::onFailure(const QString& key)
+{
+    const qint64 now = mClock.elapsed();
+    if (mFailures.size() >= FailuresLimit) {
+        for (auto it = mFailures.begin(); it != mFailures.end();) {
+            if (it->retryAt <= now) {
+                it = mFailures.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    auto failure = mFailures.find(key);
+    if (failure == mFailures.end()) {
+        failure = mFailures.insert(key, { 0, 0 });
+    }
+    failure->count = qMin(failure->count + 1, 30);
+    const qint64 delay = qMin(mBackoffMaxMs, mBackoffInitialMs << (failure->count - 1));
+    failure->retryAt = now + delay;
+    qgvDebug() << "backoff" << key << "for" << delay << "ms";
+}
+
+void QGVTileDownloader::updatePriority(const Job& job)
+{
+    if (job.priorities.isEmpty()) {
+        return;
+    }
+    qreal priority = job.priorities.constBegin().value();
+    for (qreal value : job.priorities) {
+        priority = qMin(priority, value);
+    }
+    QGV::getTileScheduler()->reprioritize(job.schedule, priority);
+}
+
+void QGVTileDownloader::abort(Job& job)
+{
+    QGV::getTileScheduler()->finish(job.schedule);
+    if (job.reply.isNull()) {
+        return;
+    }
+    qgvDebug() << "abort" << job.url;
+    disconnect(job.reply.data(), nullptr, this, nullptr);
+    job.reply->abort();
+    job.reply->deleteLater();
+}
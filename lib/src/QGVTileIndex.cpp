@@ -0,0 +1,186 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVTileIndex.h"
+
+#include <cstring>
+
+namespace {
+const int ZoomShift = 58;
+const quint64 MortonMask = (quint64(1) << ZoomShift) - 1;
+
+quint64 spreadBits(quint32 value)
+{
+    quint64 bits = value & 0x1FFFFFFF;
+    bits = (bits | (bits << 16)) & 0x0000FFFF0000FFFFull;
+    bits = (bits | (bits << 8)) & 0x00FF00FF00FF00FFull;
+    bits = (bits | (bits << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    bits = (bits | (bits << 2)) & 0x3333333333333333ull;
+    bits = (bits | (bits << 1)) & 0x5555555555555555ull;
+    return bits;
+}
+
+quint32 compactBits(quint64 bits)
+{
+    bits &= 0x5555555555555555ull;
+    bits = (bits | (bits >> 1)) & 0x3333333333333333ull;
+    bits = (bits | (bits >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+    bits = (bits | (bits >> 4)) & 0x00FF00FF00FF00FFull;
+    bits = (bits | (bits >> 8)) & 0x0000FFFF0000FFFFull;
+    bits = (bits | (bits >> 16)) & 0x00000000FFFFFFFFull;
+    return static_cast<quint32>(bits);
+}
+
+quint64 zoomBase(int zoom)
+{
+    return static_cast<quint64>(zoom) << ZoomShift;
+}
+
+quint64 morton(const QGV::GeoTilePos& tilePos)
+{
+    return spreadBits(static_cast<quint32>(tilePos.pos().x())) |
+           (spreadBits(static_cast<quint32>(tilePos.pos().y())) << 1);
+}
+}
+
+quint64 QGVTileIndex::toKey(const QGV::GeoTilePos& tilePos)
+{
+    return zoomBase(tilePos.zoom()) | morton(tilePos);
+}
+
+QGV::GeoTilePos QGVTileIndex::fromKey(quint64 key)
+{
+    const int zoom = static_cast<int>(key >> ZoomShift);
+    const quint64 code = key & MortonMask;
+    return QGV::GeoTilePos(zoom, QPoint(static_cast<int>(compactBits(code)), static_cast<int>(compactBits(code >> 1))));
+}
+
+QGVTileIndex::QGVTileIndex()
+{
+    std::memset(mZoomCount, 0, sizeof(mZoomCount));
+}
+
+bool QGVTileIndex::isEmpty() const
+{
+    return mItems.isEmpty();
+}
+
+int QGVTileIndex::count() const
+{
+    return static_cast<int>(mItems.size());
+}
+
+int QGVTileIndex::count(int zoom) const
+{
+    if (zoom < 0 || zoom > MaxZoom) {
+        return 0;
+    }
+    return mZoomCount[zoom];
+}
+
+bool QGVTileIndex::contains(const QGV::GeoTilePos& tilePos) const
+{
+    return mItems.contains(toKey(tilePos));
+}
+
+QGVDrawItem* QGVTileIndex::value(const QGV::GeoTilePos& tilePos) const
+{
+    return mItems.value(toKey(tilePos), nullptr);
+}
+
+void QGVTileIndex::insert(const QGV::GeoTilePos& tilePos, QGVDrawItem* item)
+{
+    Q_ASSERT(tilePos.zoom() >= 0 && tilePos.zoom() <= MaxZoom);
+    const quint64 key = toKey(tilePos);
+    auto it = mItems.find(key);
+    if (it == mItems.end()) {
+        mItems.insert(key, item);
+        mZoomCount[tilePos.zoom()]++;
+    } else {
+        it.value() = item;
+    }
+    mOrdered.insert(key, item);
+}
+
+QGVDrawItem* QGVTileIndex::take(const QGV::GeoTilePos& tilePos)
+{
+    const quint64 key = toKey(tilePos);
+    auto it = mItems.find(key);
+    if (it == mItems.end()) {
+        return nullptr;
+    }
+    QGVDrawItem* item = it.value();
+    mItems.erase(it);
+    mOrdered.remove(key);
+    mZoomCount[tilePos.zoom()]--;
+    return item;
+}
+
+void QGVTileIndex::clear()
+{
+    mItems.clear();
+    mOrdered.clear();
+    std::memset(mZoomCount, 0, sizeof(mZoomCount));
+}
+
+void QGVTileIndex::tiles(int zoom, TileList& result) const
+{
+    result.clear();
+    if (count(zoom) == 0) {
+        return;
+    }
+    const quint64 last = zoomBase(zoom + 1);
+    for (auto it = mOrdered.lowerBound(zoomBase(zoom)); it != mOrdered.constEnd() && it.key() < last; ++it) {
+        result.append(fromKey(it.key()));
+    }
+}
+
+void QGVTileIndex::descendants(const QGV::GeoTilePos& tilePos, int fromZoom, int toZoom, TileList& result) const
+{
+    result.clear();
+    const quint64 code = morton(tilePos);
+    fromZoom = qMax(fromZoom, tilePos.zoom() + 1);
+    toZoom = qMin(toZoom, static_cast<int>(MaxZoom));
+    for (int zoom = fromZoom; zoom <= toZoom; ++zoom) {
+        if (mZoomCount[zoom] == 0) {
+            continue;
+        }
+        const int shift = 2 * (zoom - tilePos.zoom());
+        const quint64 first = zoomBase(zoom) + (code << shift);
+        const quint64 last = zoomBase(zoom) + ((code + 1) << shift);
+        for (auto it = mOrdered.lowerBound(first); it != mOrdered.constEnd() && it.key() < last; ++it) {
+            result.append(fromKey(it.key()));
+        }
+    }
+}
+
+void QGVTileIndex::ancestors(const QGV::GeoTilePos& tilePos, int fromZoom, TileList& result) const
+{
+    result.clear();
+    const quint64 code = morton(tilePos);
+    for (int zoom = qMax(0, fromZoom); zoom < tilePos.zoom(); ++zoom) {
+        if (mZoomCount[zoom] == 0) {
+            continue;
+        }
+        const int shift = 2 * (tilePos.zoom() - zoom);
+        const quint64 key = zoomBase(zoom) + (code >> shift);
+        if (mItems.contains(key)) {
+            result.append(fromKey(key));
+        }
+    }
+}
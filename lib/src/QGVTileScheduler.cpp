@@ -0,0 +1,143 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+
+#include "QGVTileScheduler.h"
+
+namespace {
+const int DefaultMaxRequestsPerHost = 6;
+}
+
+QGVTileScheduler::QGVTileScheduler(QObject* parent)
+    : QObject(parent)
+    , mMaxRequestsPerHost(DefaultMaxRequestsPerHost)
+    , mTicket(0)
+{
+    mDispatchTimer.setSingleShot(true);
+    mDispatchTimer.setInterval(0);
+    connect(&mDispatchTimer, &QTimer::timeout, this, &QGVTileScheduler::dispatch);
+}
+
+void QGVTileScheduler::setMaxRequestsPerHost(int count)
+{
+    mMaxRequestsPerHost = qMax(1, count);
+    qgvDebug() << "max requests per host changed to" << mMaxRequestsPerHost;
+    scheduleDispatch();
+}
+
+int QGVTileScheduler::getMaxRequestsPerHost() const
+{
+    return mMaxRequestsPerHost;
+}
+
+int QGVTileScheduler::queued() const
+{
+    int result = 0;
+    for (const auto& queue : mQueues) {
+        result += queue.size();
+    }
+    return result;
+}
+
+int QGVTileScheduler::queued(const QString& host) const
+{
+    return mQueues.value(host).size();
+}
+
+int QGVTileScheduler::inFlight(const QString& host) const
+{
+    return mInFlight.value(host, 0);
+}
+
+quint64 QGVTileScheduler::enqueue(const QString& host, qreal priority, const Start& start)
+{
+    const quint64 ticket = ++mTicket;
+    mRequests.insert(ticket, { host, priority, false, start });
+    mQueues[host].insert(Rank(priority, ticket), ticket);
+    scheduleDispatch();
+    return ticket;
+}
+
+void QGVTileScheduler::reprioritize(quint64 ticket, qreal priority)
+{
+    auto it = mRequests.find(ticket);
+    if (it == mRequests.end() || it->started || it->priority == priority) {
+        return;
+    }
+    auto& queue = mQueues[it->host];
+    queue.remove(Rank(it->priority, ticket));
+    it->priority = priority;
+    queue.insert(Rank(priority, ticket), ticket);
+}
+
+bool QGVTileScheduler::isStarted(quint64 ticket) const
+{
+    auto it = mRequests.constFind(ticket);
+    return it != mRequests.constEnd() && it->started;
+}
+
+void QGVTileScheduler::finish(quint64 ticket)
+{
+    auto it = mRequests.find(ticket);
+    if (it == mRequests.end()) {
+        return;
+    }
+    if (it->started) {
+        mInFlight[it->host]--;
+        scheduleDispatch();
+    } else {
+        mQueues[it->host].remove(Rank(it->priority, ticket));
+    }
+    mRequests.erase(it);
+}
+
+void QGVTileScheduler::scheduleDispatch()
+{
+    if (!mDispatchTimer.isActive()) {
+        mDispatchTimer.start();
+    }
+}
+
+void QGVTileScheduler::dispatch()
+{
+    QList<quint64> started;
+    for (auto queueIt = mQueues.begin(); queueIt != mQueues.end();) {
+        auto& queue = queueIt.value();
+        int& inFlight = mInFlight[queueIt.key()];
+        while (!queue.isEmpty() && inFlight < mMaxRequestsPerHost) {
+            const quint64 ticket = queue.take(queue.firstKey());
+            Request& request = mRequests[ticket];
+            request.started = true;
+            inFlight++;
+            started.append(ticket);
+        }
+        if (queue.isEmpty()) {
+            queueIt = mQueues.erase(queueIt);
+        } else {
+            ++queueIt;
+        }
+    }
+    for (quint64 ticket : started) {
+        // request can be finished by previous start
+        auto it = mRequests.constFind(ticket);
+        if (it != mRequests.constEnd()) {
+            const Start start = it->start;
+            start();
+        }
+    }
+}
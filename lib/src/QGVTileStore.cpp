@@ -0,0 +1,564 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVTileStore.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+/*
+ * Pack file layout (little-endian):
+ * file header   - magic[8], version(u32), reserved(u32)
+ * record header - magic(u32), flags(u32), layer(u64), tile(u64), stamp(u64), size(u32), reserved(u32)
+ * record data   - size bytes of raw tile data
+ */
+const char FileMagic[8] = { 'Q', 'G', 'V', 'T', 'P', 'A', 'C', 'K' };
+const quint32 FileVersion = 2;
+const qint64 FileHeaderSize = 16;
+const quint32 RecordMagic = 0x54564751;
+const qint64 RecordHeaderSize = 40;
+const qint64 RecordFlagsOffset = 4;
+const qint64 RecordLayerOffset = 8;
+const qint64 RecordTileOffset = 16;
+const qint64 RecordStampOffset = 24;
+const qint64 RecordSizeOffset = 32;
+const quint32 RecordFlagDeleted = 0x1;
+const qint64 CompactThreshold = 16 * 1024 * 1024;
+const qint64 DefaultMaxBytes = 512 * 1024 * 1024;
+
+quint64 layerHash(const QString& layerId)
+{
+    // 64-bit FNV-1a, stable between runs and Qt versions
+    quint64 hash = Q_UINT64_C(14695981039346656037);
+    for (const char symbol : layerId.toUtf8()) {
+        hash ^= static_cast<quint8>(symbol);
+        hash *= Q_UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+quint64 tileHash(const QGV::GeoTilePos& tilePos)
+{
+    const quint64 mask = 0x1FFFFFFF;
+    return (static_cast<quint64>(tilePos.zoom()) << 58) | ((static_cast<quint64>(tilePos.pos().x()) & mask) << 29) |
+           (static_cast<quint64>(tilePos.pos().y()) & mask);
+}
+
+void fillRecordHeader(uchar* dst, quint64 layer, quint64 tile, quint64 stamp, quint32 size, quint32 flags)
+{
+    qToLittleEndian<quint32>(RecordMagic, dst + 0);
+    qToLittleEndian<quint32>(flags, dst + RecordFlagsOffset);
+    qToLittleEndian<quint64>(layer, dst + RecordLayerOffset);
+    qToLittleEndian<quint64>(tile, dst + RecordTileOffset);
+    qToLittleEndian<quint64>(stamp, dst + RecordStampOffset);
+    qToLittleEndian<quint32>(size, dst + RecordSizeOffset);
+    qToLittleEndian<quint32>(0, dst + RecordSizeOffset + 4);
+}
+
+bool writeFileHeader(QFile& file)
+{
+    uchar header[FileHeaderSize] = {};
+    memcpy(header, FileMagic, sizeof(FileMagic));
+    qToLittleEndian<quint32>(FileVersion, header + 8);
+    return file.write(reinterpret_cast<const char*>(header), FileHeaderSize) == FileHeaderSize;
+}
+}
+
+class QGVTileStore::Writer : public QRunnable
+{
+public:
+    explicit Writer(QGVTileStore* store)
+        : mStore(store)
+    {
+    }
+
+    void run() override
+    {
+        mStore->writePending();
+    }
+
+private:
+    QGVTileStore* mStore;
+};
+
+QGVTileStore::QGVTileStore(const QString& filePath, QObject* parent)
+    : QGVTileStore(filePath, Access::ReadWrite, parent)
+{
+}
+
+QGVTileStore::QGVTileStore(const QString& filePath, Access access, QObject* parent)
+    : QObject(parent)
+    , mFilePath(filePath)
+    , mReadOnly(access == Access::ReadOnly)
+    , mMaxBytes(DefaultMaxBytes)
+    , mUsedBytes(0)
+    , mDeadBytes(0)
+    , mTick(0)
+    , mWriteScheduled(false)
+    , mMap(nullptr)
+    , mMapSize(0)
+{
+    mPool.setMaxThreadCount(1);
+    open();
+}
+
+QGVTileStore::~QGVTileStore()
+{
+    flush();
+    mPool.waitForDone();
+    QMutexLocker locker(&mMutex);
+    unmap();
+}
+
+QString QGVTileStore::getFilePath() const
+{
+    return mFilePath;
+}
+
+bool QGVTileStore::isReadOnly() const
+{
+    return mReadOnly;
+}
+
+void QGVTileStore::setMaxBytes(qint64 maxBytes)
+{
+    QMutexLocker locker(&mMutex);
+    mMaxBytes = qMax(qint64(0), maxBytes);
+    evict();
+    scheduleWrite();
+    qgvDebug() << "tile store budget changed to" << mMaxBytes;
+}
+
+qint64 QGVTileStore::getMaxBytes() const
+{
+    QMutexLocker locker(&mMutex);
+    return mMaxBytes;
+}
+
+qint64 QGVTileStore::getUsedBytes() const
+{
+    QMutexLocker locker(&mMutex);
+    return mUsedBytes;
+}
+
+int QGVTileStore::count() const
+{
+    QMutexLocker locker(&mMutex);
+    return mIndex.size();
+}
+
+bool QGVTileStore::contains(const QString& layerId, const QGV::GeoTilePos& tilePos) const
+{
+    const Key key = makeKey(layerId, tilePos);
+    QMutexLocker locker(&mMutex);
+    return mPending.contains(key) || mIndex.contains(key);
+}
+
+QByteArray QGVTileStore::load(const QString& layerId, const QGV::GeoTilePos& tilePos)
+{
+    const Key key = makeKey(layerId, tilePos);
+    QMutexLocker locker(&mMutex);
+    const auto pending = mPending.constFind(key);
+    if (pending != mPending.constEnd()) {
+        return pending.value();
+    }
+    auto it = mIndex.find(key);
+    if (it == mIndex.end()) {
+        return {};
+    }
+    Entry& entry = it.value();
+    if (entry.offset + entry.size > mMapSize && !remap(mReader.size())) {
+        return {};
+    }
+    if (mReadOnly) {
+        // read-only pack is never remapped, so data is not copied
+        return QByteArray::fromRawData(reinterpret_cast<const char*>(mMap + entry.offset),
+                                       static_cast<int>(entry.size));
+    }
+    const QByteArray result(reinterpret_cast<const char*>(mMap + entry.offset), static_cast<int>(entry.size));
+    touch(key, entry);
+    return result;
+}
+
+void QGVTileStore::save(const QString& layerId, const QGV::GeoTilePos& tilePos, const QByteArray& rawData)
+{
+    if (rawData.isEmpty() || mReadOnly) {
+        return;
+    }
+    const Key key = makeKey(layerId, tilePos);
+    QMutexLocker locker(&mMutex);
+    if (RecordHeaderSize + rawData.size() > mMaxBytes) {
+        return;
+    }
+    mPending.insert(key, rawData);
+    scheduleWrite();
+}
+
+void QGVTileStore::flush()
+{
+    mPool.waitForDone();
+    writePending();
+}
+
+void QGVTileStore::clear()
+{
+    if (mReadOnly) {
+        qgvWarning() << "read-only tile store can't be cleared" << mFilePath;
+        return;
+    }
+    mPool.waitForDone();
+    QMutexLocker locker(&mMutex);
+    unmap();
+    mIndex.clear();
+    mLru.clear();
+    mPending.clear();
+    mTouched.clear();
+    mDeleted.clear();
+    mUsedBytes = 0;
+    mDeadBytes = 0;
+    mWriter.resize(FileHeaderSize);
+    qgvDebug() << "tile store cleared" << mFilePath;
+}
+
+QGVTileStore::Key QGVTileStore::makeKey(const QString& layerId, const QGV::GeoTilePos& tilePos)
+{
+    return Key(layerHash(layerId), tileHash(tilePos));
+}
+
+void QGVTileStore::open()
+{
+    if (mReadOnly) {
+        openReadOnly();
+        return;
+    }
+    QDir().mkpath(QFileInfo(mFilePath).absolutePath());
+    mWriter.setFileName(mFilePath);
+    if (!mWriter.open(QIODevice::ReadWrite)) {
+        qgvCritical() << "ERROR" << "tile store can't be opened" << mFilePath << mWriter.errorString();
+        return;
+    }
+    const QByteArray header = mWriter.read(FileHeaderSize);
+    const uchar* headerData = reinterpret_cast<const uchar*>(header.constData());
+    const bool valid = header.size() == FileHeaderSize && memcmp(headerData, FileMagic, sizeof(FileMagic)) == 0 &&
+                       qFromLittleEndian<quint32>(headerData + 8) == FileVersion;
+    if (!valid) {
+        if (!header.isEmpty()) {
+            qgvWarning() << "tile store has unknown format and will be reset" << mFilePath;
+        }
+        mWriter.resize(0);
+        mWriter.seek(0);
+        writeFileHeader(mWriter);
+        mWriter.flush();
+    }
+    mReader.setFileName(mFilePath);
+    if (!mReader.open(QIODevice::ReadOnly)) {
+        qgvCritical() << "ERROR" << "tile store can't be mapped" << mFilePath << mReader.errorString();
+        mWriter.close();
+        return;
+    }
+    QMutexLocker locker(&mMutex);
+    scan();
+    evict();
+    if (mDeadBytes > 0) {
+        scheduleWrite();
+    }
+    qgvDebug() << "tile store" << mFilePath << "opened with" << mIndex.size() << "tiles";
+}
+
+void QGVTileStore::openReadOnly()
+{
+    mReader.setFileName(mFilePath);
+    if (!mReader.open(QIODevice::ReadOnly)) {
+        qgvCritical() << "ERROR" << "tile store can't be opened" << mFilePath << mReader.errorString();
+        return;
+    }
+    const QByteArray header = mReader.read(FileHeaderSize);
+    const uchar* headerData = reinterpret_cast<const uchar*>(header.constData());
+    const bool valid = header.size() == FileHeaderSize && memcmp(headerData, FileMagic, sizeof(FileMagic)) == 0 &&
+                       qFromLittleEndian<quint32>(headerData + 8) == FileVersion;
+    if (!valid) {
+        qgvWarning() << "tile store has unknown format" << mFilePath;
+        mReader.close();
+        return;
+    }
+    QMutexLocker locker(&mMutex);
+    scan();
+    qgvDebug() << "read-only tile store" << mFilePath << "opened with" << mIndex.size() << "tiles";
+}
+
+void QGVTileStore::scan()
+{
+    const qint64 fileSize = mReader.size();
+    if (!remap(fileSize)) {
+        return;
+    }
+    QList<QPair<quint64, Key>> order;
+    qint64 pos = FileHeaderSize;
+    while (pos + RecordHeaderSize <= fileSize) {
+        const uchar* header = mMap + pos;
+        if (qFromLittleEndian<quint32>(header + 0) != RecordMagic) {
+            break;
+        }
+        const quint32 size = qFromLittleEndian<quint32>(header + RecordSizeOffset);
+        if (pos + RecordHeaderSize + size > fileSize) {
+            break;
+        }
+        const Key key(qFromLittleEndian<quint64>(header + RecordLayerOffset),
+                      qFromLittleEndian<quint64>(header + RecordTileOffset));
+        const quint64 stamp = qFromLittleEndian<quint64>(header + RecordStampOffset);
+        const quint32 flags = qFromLittleEndian<quint32>(header + RecordFlagsOffset);
+        if ((flags & RecordFlagDeleted) == 0) {
+            const auto existing = mIndex.constFind(key);
+            if (existing != mIndex.constEnd()) {
+                mDeadBytes += RecordHeaderSize + existing->size;
+                mUsedBytes -= RecordHeaderSize + existing->size;
+            }
+            mIndex.insert(key, Entry{ pos + RecordHeaderSize, size, stamp });
+            mUsedBytes += RecordHeaderSize + size;
+            order.append(qMakePair(stamp, key));
+        } else {
+            mDeadBytes += RecordHeaderSize + size;
+        }
+        pos += RecordHeaderSize + size;
+    }
+    if (pos < fileSize && mReadOnly) {
+        qgvWarning() << "tile store has broken record at" << pos << "of" << fileSize;
+    } else if (pos < fileSize) {
+        qgvWarning() << "tile store truncated at" << pos << "of" << fileSize;
+        unmap();
+        mWriter.resize(pos);
+        remap(pos);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const QPair<quint64, Key>& left, const QPair<quint64, Key>& right) {
+        return left.first < right.first;
+    });
+    for (const auto& item : order) {
+        auto it = mIndex.find(item.second);
+        if (it == mIndex.end() || it->stamp != item.first || mLru.contains(it->stamp)) {
+            continue;
+        }
+        mLru.insert(it->stamp, it.key());
+        mTick = qMax(mTick, it->stamp);
+    }
+    for (auto it = mIndex.begin(); it != mIndex.end(); ++it) {
+        if (!mLru.contains(it->stamp) || mLru.value(it->stamp) != it.key()) {
+            it->stamp = ++mTick;
+            mLru.insert(it->stamp, it.key());
+        }
+    }
+}
+
+bool QGVTileStore::remap(qint64 size)
+{
+    if (mMap != nullptr && mMapSize == size) {
+        return true;
+    }
+    unmap();
+    if (size <= 0) {
+        return true;
+    }
+    mMap = mReader.map(0, size);
+    if (mMap == nullptr) {
+        qgvCritical() << "ERROR" << "tile store mapping failed" << mFilePath << mReader.errorString();
+        return false;
+    }
+    mMapSize = size;
+    return true;
+}
+
+void QGVTileStore::unmap()
+{
+    if (mMap != nullptr) {
+        mReader.unmap(mMap);
+    }
+    mMap = nullptr;
+    mMapSize = 0;
+}
+
+void QGVTileStore::touch(const Key& key, Entry& entry)
+{
+    mLru.remove(entry.stamp);
+    entry.stamp = ++mTick;
+    mLru.insert(entry.stamp, key);
+    mTouched.insert(entry.offset - RecordHeaderSize, entry.stamp);
+}
+
+void QGVTileStore::evict()
+{
+    if (mReadOnly) {
+        return;
+    }
+    while (mUsedBytes > mMaxBytes && !mLru.isEmpty()) {
+        const Key key = mLru.take(mLru.firstKey());
+        const Entry entry = mIndex.take(key);
+        const qint64 recordSize = RecordHeaderSize + entry.size;
+        mUsedBytes -= recordSize;
+        mDeadBytes += recordSize;
+        mTouched.remove(entry.offset - RecordHeaderSize);
+        mDeleted.append(entry.offset - RecordHeaderSize);
+    }
+}
+
+void QGVTileStore::scheduleWrite()
+{
+    if (mWriteScheduled || !mWriter.isOpen()) {
+        return;
+    }
+    mWriteScheduled = true;
+    mPool.start(new Writer(this));
+}
+
+void QGVTileStore::writePending()
+{
+    QMutexLocker locker(&mMutex);
+    mWriteScheduled = false;
+    if (!mWriter.isOpen()) {
+        return;
+    }
+    const QHash<Key, QByteArray> pending = mPending;
+    const QHash<qint64, quint64> touched = mTouched;
+    const QList<qint64> deleted = mDeleted;
+    const quint64 firstStamp = mTick + 1;
+    mTick += static_cast<quint64>(pending.size());
+    mTouched.clear();
+    mDeleted.clear();
+    locker.unlock();
+
+    uchar buffer[RecordHeaderSize];
+    for (auto it = touched.constBegin(); it != touched.constEnd(); ++it) {
+        qToLittleEndian<quint64>(it.value(), buffer);
+        mWriter.seek(it.key() + RecordStampOffset);
+        mWriter.write(reinterpret_cast<const char*>(buffer), sizeof(quint64));
+    }
+    for (const qint64 offset : deleted) {
+        qToLittleEndian<quint32>(RecordFlagDeleted, buffer);
+        mWriter.seek(offset + RecordFlagsOffset);
+        mWriter.write(reinterpret_cast<const char*>(buffer), sizeof(quint32));
+    }
+    QHash<Key, Entry> written;
+    quint64 stamp = firstStamp;
+    qint64 pos = mWriter.size();
+    bool failed = false;
+    mWriter.seek(pos);
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it, ++stamp) {
+        const QByteArray& data = it.value();
+        const quint32 size = static_cast<quint32>(data.size());
+        fillRecordHeader(buffer, it.key().first, it.key().second, stamp, size, 0);
+        if (mWriter.write(reinterpret_cast<const char*>(buffer), RecordHeaderSize) != RecordHeaderSize ||
+            mWriter.write(data) != data.size()) {
+            qgvCritical() << "ERROR" << "tile store write failed" << mFilePath << mWriter.errorString();
+            mWriter.resize(pos);
+            failed = true;
+            break;
+        }
+        written.insert(it.key(), Entry{ pos + RecordHeaderSize, size, stamp });
+        pos += RecordHeaderSize + size;
+    }
+    mWriter.flush();
+
+    locker.relock();
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        const Key& key = it.key();
+        const bool isWritten = written.contains(key);
+        if (!isWritten && !failed) {
+            continue;
+        }
+        if (mPending.value(key).constData() == it.value().constData()) {
+            mPending.remove(key);
+        }
+        if (!isWritten) {
+            continue;
+        }
+        auto existing = mIndex.find(key);
+        if (existing != mIndex.end()) {
+            const qint64 recordSize = RecordHeaderSize + existing->size;
+            mUsedBytes -= recordSize;
+            mDeadBytes += recordSize;
+            mLru.remove(existing->stamp);
+            mTouched.remove(existing->offset - RecordHeaderSize);
+            mDeleted.append(existing->offset - RecordHeaderSize);
+        }
+        const Entry entry = written.value(key);
+        mIndex.insert(key, entry);
+        mLru.insert(entry.stamp, key);
+        mUsedBytes += RecordHeaderSize + entry.size;
+    }
+    evict();
+    if (mDeadBytes > qMax(mUsedBytes, CompactThreshold)) {
+        compact();
+    }
+    if (!mPending.isEmpty() || !mDeleted.isEmpty()) {
+        scheduleWrite();
+    }
+}
+
+void QGVTileStore::compact()
+{
+    const QString tmpPath = mFilePath + ".tmp";
+    QFile tmp(tmpPath);
+    if (!tmp.open(QIODevice::WriteOnly | QIODevice::Truncate) || !writeFileHeader(tmp)) {
+        qgvCritical() << "ERROR" << "tile store compaction failed" << tmpPath << tmp.errorString();
+        return;
+    }
+    if (!remap(mReader.size())) {
+        return;
+    }
+    QHash<Key, Entry> index;
+    qint64 pos = FileHeaderSize;
+    uchar header[RecordHeaderSize];
+    for (auto it = mIndex.constBegin(); it != mIndex.constEnd(); ++it) {
+        const Entry& entry = it.value();
+        fillRecordHeader(header, it.key().first, it.key().second, entry.stamp, entry.size, 0);
+        if (tmp.write(reinterpret_cast<const char*>(header), RecordHeaderSize) != RecordHeaderSize ||
+            tmp.write(reinterpret_cast<const char*>(mMap + entry.offset), entry.size) != entry.size) {
+            qgvCritical() << "ERROR" << "tile store compaction failed" << tmpPath << tmp.errorString();
+            tmp.remove();
+            return;
+        }
+        index.insert(it.key(), Entry{ pos + RecordHeaderSize, entry.size, entry.stamp });
+        pos += RecordHeaderSize + entry.size;
+    }
+    tmp.close();
+
+    unmap();
+    mReader.close();
+    mWriter.close();
+    QFile::remove(mFilePath);
+    QFile::rename(tmpPath, mFilePath);
+    if (!mWriter.open(QIODevice::ReadWrite) || !mReader.open(QIODevice::ReadOnly)) {
+        qgvCritical() << "ERROR" << "tile store can't be reopened" << mFilePath << mWriter.errorString();
+        mWriter.close();
+        mIndex.clear();
+        mLru.clear();
+        mUsedBytes = 0;
+        return;
+    }
+    mIndex = index;
+    mDeadBytes = 0;
+    mTouched.clear();
+    mDeleted.clear();
+    remap(pos);
+    qgvDebug() << "tile store compacted to" << pos << "bytes";
+}
@@ -0,0 +1,290 @@
+/***************************************************************************
+ * QGeoView is a Qt / C ++ widget for visualizing geographic data.
+ * Copyright (C) 2018-2025 Andrey Yaroshenko.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see https://www.gnu.org/licenses.
+ ****************************************************************************/
+
+#include "QGVUrlTemplate.h"
+
+#include <QUrl>
+#include <QtMath>
+
+namespace {
+struct Token
+{
+    const char* text;
+    QGVUrlTemplate::Field field;
+    Qt::CaseSensitivity cs;
+    bool wms;
+};
+
+// clang-format off
+const Token Tokens[] = {
+    { "${x}", QGVUrlTemplate::Field::X, Qt::CaseInsensitive, false },
+    { "${y}", QGVUrlTemplate::Field::Y, Qt::CaseInsensitive, false },
+    { "${z}", QGVUrlTemplate::Field::Zoom, Qt::CaseInsensitive, false },
+    { "${qk}", QGVUrlTemplate::Field::QuadKey, Qt::CaseInsensitive, false },
+    { "${lcl}", QGVUrlTemplate::Field::Locale, Qt::CaseInsensitive, false },
+    { "${r}", QGVUrlTemplate::Field::Retina, Qt::CaseInsensitive, false },
+    { "lonLeft", QGVUrlTemplate::Field::LonLeft, Qt::CaseSensitive, true },
+    { "latBottom", QGVUrlTemplate::Field::LatBottom, Qt::CaseSensitive, true },
+    { "lonRight", QGVUrlTemplate::Field::LonRight, Qt::CaseSensitive, true },
+    { "latTop", QGVUrlTemplate::Field::LatTop, Qt::CaseSensitive, true },
+    { "WIDTH", QGVUrlTemplate::Field::Width, Qt::CaseSensitive, true },
+    { "HEIGHT", QGVUrlTemplate::Field::Height, Qt::CaseSensitive, true },
+};
+// clang-format on
+
+const int GeoRectFields = (1 << static_cast<int>(QGVUrlTemplate::Field::LonLeft)) |
+                          (1 << static_cast<int>(QGVUrlTemplate::Field::LatBottom)) |
+                          (1 << static_cast<int>(QGVUrlTemplate::Field::LonRight)) |
+                          (1 << static_cast<int>(QGVUrlTemplate::Field::LatTop));
+
+// Number formatting into stack buffer, independent of C locale and without heap allocation
+void appendInt(QString& out, qint64 value)
+{
+    char buffer[24];
+    int pos = sizeof(buffer);
+    const bool negative = value < 0;
+    quint64 abs = negative ? static_cast<quint64>(-value) : static_cast<quint64>(value);
+    do {
+        buffer[--pos] = static_cast<char>('0' + abs % 10);
+        abs /= 10;
+    } while (abs != 0);
+    if (negative) {
+        buffer[--pos] = '-';
+    }
+    out.append(QLatin1String(buffer + pos, static_cast<int>(sizeof(buffer)) - pos));
+}
+
+void appendFixed6(QString& out, double value)
+{
+    const bool negative = value < 0;
+    const qint64 scaled = qRound64(qAbs(value) * 1e6);
+    if (negative && scaled != 0) {
+        out.append(QLatin1Char('-'));
+    }
+    appendInt(out, scaled / 1000000);
+    char buffer[7];
+    qint64 frac = scaled % 1000000;
+    buffer[0] = '.';
+    for (int i = 6; i > 0; i--) {
+        buffer[i] = static_cast<char>('0' + frac % 10);
+        frac /= 10;
+    }
+    out.append(QLatin1String(buffer, 7));
+}
+
+void appendQuadKey(QString& out, const QGV::GeoTilePos& tilePos)
+{
+    char buffer[32];
+    const int zoom = qMin(tilePos.zoom(), static_cast<int>(sizeof(buffer)));
+    const int x = tilePos.pos().x();
+    const int y = tilePos.pos().y();
+    for (int i = zoom; i > 0; i--) {
+        const int mask = 1 << (i - 1);
+        buffer[zoom - i] = static_cast<char>('0' + ((x & mask) != 0 ? 1 : 0) + ((y & mask) != 0 ? 2 : 0));
+    }
+    out.append(QLatin1String(buffer, zoom));
+}
+}
+
+QGVUrlTemplate::QGVUrlTemplate()
+    : mFields(0)
+    , mWmsFields(false)
+    , mRetina(false)
+{
+}
+
+QGVUrlTemplate::QGVUrlTemplate(const QString& pattern, bool wmsFields)
+    : mPattern(pattern)
+    , mFields(0)
+    , mWmsFields(wmsFields)
+    , mRetina(false)
+{
+    parse();
+}
+
+void QGVUrlTemplate::setPattern(const QString& pattern)
+{
+    mPattern = pattern;
+    parse();
+}
+
+QString QGVUrlTemplate::getPattern() const
+{
+    return mPattern;
+}
+
+void QGVUrlTemplate::setWmsFields(bool enabled)
+{
+    if (mWmsFields == enabled) {
+        return;
+    }
+    mWmsFields = enabled;
+    parse();
+}
+
+bool QGVUrlTemplate::isWmsFields() const
+{
+    return mWmsFields;
+}
+
+void QGVUrlTemplate::setLocale(const QString& locale)
+{
+    mLocale = locale;
+}
+
+QString QGVUrlTemplate::getLocale() const
+{
+    return mLocale;
+}
+
+void QGVUrlTemplate::setRetina(bool enabled)
+{
+    mRetina = enabled;
+}
+
+bool QGVUrlTemplate::isRetina() const
+{
+    return mRetina;
+}
+
+QString QGVUrlTemplate::getHost() const
+{
+    return mHost;
+}
+
+bool QGVUrlTemplate::isEmpty() const
+{
+    return mSegments.isEmpty();
+}
+
+bool QGVUrlTemplate::hasField(Field field) const
+{
+    return (mFields & (1 << static_cast<int>(field))) != 0;
+}
+
+bool QGVUrlTemplate::hasGeoRect() const
+{
+    return (mFields & GeoRectFields) != 0;
+}
+
+int QGVUrlTemplate::sizeHint() const
+{
+    return mPattern.size() + mLocale.size() + 64;
+}
+
+QString QGVUrlTemplate::expand(const QGV::GeoTilePos& tilePos) const
+{
+    return expand(tilePos, hasGeoRect() ? tilePos.toGeoRect() : QGV::GeoRect(), {});
+}
+
+QString QGVUrlTemplate::expand(const QGV::GeoTilePos& tilePos, const QGV::GeoRect& geoRect, const QSize& size) const
+{
+    QString out;
+    out.reserve(sizeHint());
+    expand(out, tilePos, geoRect, size);
+    return out;
+}
+
+void QGVUrlTemplate::expand(QString& out,
+                            const QGV::GeoTilePos& tilePos,
+                            const QGV::GeoRect& geoRect,
+                            const QSize& size) const
+{
+    out.resize(0);
+    for (const Segment& segment : mSegments) {
+        switch (segment.field) {
+            case Field::Text:
+                out.append(mPattern.constData() + segment.from, segment.length);
+                break;
+            case Field::X:
+                appendInt(out, tilePos.pos().x());
+                break;
+            case Field::Y:
+                appendInt(out, tilePos.pos().y());
+                break;
+            case Field::Zoom:
+                appendInt(out, tilePos.zoom());
+                break;
+            case Field::QuadKey:
+                appendQuadKey(out, tilePos);
+                break;
+            case Field::Locale:
+                out.append(mLocale);
+                break;
+            case Field::Retina:
+                if (mRetina) {
+                    out.append(QLatin1String("@2x"));
+                }
+                break;
+            case Field::LonLeft:
+                appendFixed6(out, geoRect.lonLeft());
+                break;
+            case Field::LatBottom:
+                appendFixed6(out, geoRect.latBottom());
+                break;
+            case Field::LonRight:
+                appendFixed6(out, geoRect.lonRight());
+                break;
+            case Field::LatTop:
+                appendFixed6(out, geoRect.latTop());
+                break;
+            case Field::Width:
+                appendInt(out, size.width());
+                break;
+            case Field::Height:
+                appendInt(out, size.height());
+                break;
+        }
+    }
+}
+
+void QGVUrlTemplate::parse()
+{
+    mSegments.clear();
+    mFields = 0;
+    mHost = QUrl(mPattern).host();
+    int textFrom = 0;
+    int pos = 0;
+    while (pos < mPattern.size()) {
+        const Token* found = nullptr;
+        for (const Token& token : Tokens) {
+            if (token.wms && !mWmsFields) {
+                continue;
+            }
+            const QLatin1String text(token.text);
+            if (mPattern.mid(pos, text.size()).compare(text, token.cs) == 0) {
+                found = &token;
+                break;
+            }
+        }
+        if (found == nullptr) {
+            pos++;
+            continue;
+        }
+        if (pos > textFrom) {
+            mSegments.append({ Field::Text, textFrom, pos - textFrom });
+        }
+        mSegments.append({ found->field, pos, 0 });
+        mFields |= 1 << static_cast<int>(found->field);
+        pos += static_cast<int>(qstrlen(found->text));
+        textFrom = pos;
+    }
+    if (pos > textFrom) {
+        mSegments.append({ Field::Text, textFrom, pos - textFrom });
+    }
+}
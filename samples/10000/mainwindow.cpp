@@ -31,6 +31,7 @@ MainWindow::MainWindow()
 
     mMap = new QGVMap(this);
     setCentralWidget(mMap);
+    mMap->setDeferredUpdates(true);
 
     Helpers::setupCachedNetworkAccessManager(this);
 
@@ -71,10 +72,11 @@ QGVLayer* MainWindow::create10000Layer() const
      * Items will be owned by layer.
      */
     const int size = 20000;
+    QList<QGVItem*> items;
     for (int i = 0; i < 10000; i++) {
-        auto item = new Rectangle(Helpers::randRect(mMap, target, size), Qt::red);
-        layer->addItem(item);
+        items.append(new Rectangle(Helpers::randRect(mMap, target, size), Qt::red));
     }
+    layer->addItems(items);
 
     return layer;
 }
@@ -41,7 +41,9 @@ MainWindow::MainWindow()
     Helpers::setupCachedNetworkAccessManager(this);
 
     // Background layer
-    mBackground = new QGVLayerGoogle();
+    auto google = new QGVLayerGoogle();
+    google->setServerSharding(QGV::ServerSharding::TileHash);
+    mBackground = google;
     mMap->addItem(mBackground);
 
     // Widgets
@@ -225,6 +227,15 @@ void MainWindow::setupProfileLook()
     mBackground->setVisibleZoomLayersBelowCurrent(10);
     mBackground->setVisibleZoomLayersAboveCurrent(10);
     mBackground->setCameraUpdatesDuringAnimation(true);
+    mBackground->setPrefetchTilesBudget(32);
+    mBackground->setPrefetchLookAheadMs(750);
+    mBackground->setCompositeRendering(false);
+    mBackground->setParentTilesFallback(false);
+    mBackground->setOverzoomLevels(4);
+    mBackground->setHiDpiSelection(true);
+    mBackground->setMaxTilesBytes(0);
+    mBackground->setZoomHysteresis(0);
+    mBackground->setZoomDwellMs(0);
 }
 
 void MainWindow::setupProfileBalance()
@@ -235,6 +246,15 @@ void MainWindow::setupProfileBalance()
     mBackground->setVisibleZoomLayersBelowCurrent(1);
     mBackground->setVisibleZoomLayersAboveCurrent(3);
     mBackground->setCameraUpdatesDuringAnimation(true);
+    mBackground->setPrefetchTilesBudget(16);
+    mBackground->setPrefetchLookAheadMs(500);
+    mBackground->setCompositeRendering(true);
+    mBackground->setParentTilesFallback(true);
+    mBackground->setOverzoomLevels(4);
+    mBackground->setHiDpiSelection(true);
+    mBackground->setMaxTilesBytes(256 * 1024 * 1024);
+    mBackground->setZoomHysteresis(0.2);
+    mBackground->setZoomDwellMs(150);
 }
 
 void MainWindow::setupProfileFast()
@@ -245,4 +265,12 @@ void MainWindow::setupProfileFast()
     mBackground->setVisibleZoomLayersBelowCurrent(1);
     mBackground->setVisibleZoomLayersAboveCurrent(1);
     mBackground->setCameraUpdatesDuringAnimation(false);
+    mBackground->setPrefetchTilesBudget(0);
+    mBackground->setCompositeRendering(true);
+    mBackground->setParentTilesFallback(true);
+    mBackground->setOverzoomLevels(2);
+    mBackground->setHiDpiSelection(false);
+    mBackground->setMaxTilesBytes(64 * 1024 * 1024);
+    mBackground->setZoomHysteresis(0.3);
+    mBackground->setZoomDwellMs(300);
 }
@@ -18,6 +18,8 @@
 
 #include "helpers.h"
 
+#include <QGeoView/QGVTileStore.h>
+
 #include <QDir>
 #include <QNetworkAccessManager>
 #include <QNetworkDiskCache>
@@ -73,4 +75,11 @@ void Helpers::setupCachedNetworkAccessManager(QObject* parent)
     auto manager = new QNetworkAccessManager(parent);
     manager->setCache(cache);
     QGV::setNetworkManager(manager);
+
+    /*
+     * Tile store is persistent between application runs, unlike network cache above.
+     */
+    auto store = new QGVTileStore("storeDir/tiles.pack", parent);
+    store->setMaxBytes(256 * 1024 * 1024);
+    QGV::setTileStore(store);
 }